@@ -1,5 +1,3 @@
-#include <stdio.h>
-
 /*
 	"ccurrent" (spelled "concurrent") is a word play between "C" and "Concurrency"
 	This aims to be a portable, minimal and lightweight header-only library to
@@ -12,7 +10,8 @@
     TODO:   Write test functions for "cc_th_attr_get/setinheritsched" and "cc_th_attr_get/setscope".
 */
 
-#include "src/ccurrent.h"
+#include "src/ccurrent.h"  /* first: it sets the POSIX feature macros (see "CC_POSIX") */
+#include <stdio.h>
 
 CC_TH_FUNC_RET hello_world(void *a);
 
@@ -3,8 +3,58 @@
 
 #if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
     #define CC_POSIX
+    /*
+        clock_gettime and CLOCK_MONOTONIC under -std=c99, keeping the default (BSD/SVID) extensions visible.
+        NOTE: only effective if this header comes before any system header, or define _POSIX_C_SOURCE yourself.
+    */
+    #if !defined(_POSIX_C_SOURCE) && !defined(_GNU_SOURCE)
+        #define _POSIX_C_SOURCE 200809L
+        #if !defined(_DEFAULT_SOURCE)
+            #define _DEFAULT_SOURCE
+        #endif
+        #if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+            #define _DARWIN_C_SOURCE
+        #endif
+    #endif
     #include <pthread.h>
     #include <stdint.h>
+    #include <stdlib.h>
+    #include <errno.h>
+    #include <limits.h>
+    #include <time.h>
+    #include <string.h>
+    #include <unistd.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #if !defined(CC_FIBER_UCONTEXT) && defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+        #define CC__FIBER_ASM  /* hand-written context switch, "cc__fiber_switch_asm" */
+    #else
+        #include <ucontext.h>
+    #endif
+    #if defined(__linux__)
+        #include <linux/futex.h>
+        #include <sys/syscall.h>
+        #include <stdio.h>
+        #if !defined(_GNU_SOURCE)
+            int sched_getcpu(void);  /* glibc and musl only declare it under _GNU_SOURCE */
+        #endif
+    #endif
+
+    #define CC__NOINLINE        __attribute__((noinline, unused))
+    #if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 8
+        #define CC__NOIPA       __attribute__((noipa, unused))  /* see "cc_wait" */
+    #else
+        #define CC__NOIPA       CC__NOINLINE
+    #endif
+    #define CC__ALIGNED(n)      __attribute__((aligned(n)))
+    #define CC__LIKELY(x)       __builtin_expect(!!(x), 1)
+    #define CC__SHARED          __attribute__((weak))  /* one definition across translation units */
+
+    #define CC_MO_RELAXED       __ATOMIC_RELAXED
+    #define CC_MO_ACQUIRE       __ATOMIC_ACQUIRE
+    #define CC_MO_RELEASE       __ATOMIC_RELEASE
+    #define CC_MO_ACQ_REL       __ATOMIC_ACQ_REL
+    #define CC_MO_SEQ_CST       __ATOMIC_SEQ_CST
 
     #define CC_TH_FUNC_RET      void *
     #define CC_TH_RETURN(val)   return (void *)(intptr_t)val
@@ -23,6 +73,28 @@
 #elif defined(_WIN32)
     #define CC_WINDOWS
     #include <windows.h>
+    #include <stdint.h>
+    #include <stdlib.h>
+    #include <errno.h>
+    #include <limits.h>
+    #include <time.h>
+    #include <string.h>
+    #include <intrin.h>
+    #if defined(_MSC_VER)
+        #pragma comment(lib, "Synchronization.lib")  /* WaitOnAddress, WakeByAddress* */
+    #endif
+
+    #define CC__NOINLINE        __declspec(noinline)
+    #define CC__NOIPA           __declspec(noinline)
+    #define CC__ALIGNED(n)      __declspec(align(n))
+    #define CC__LIKELY(x)       (x)
+    #define CC__SHARED          __declspec(selectany)  /* one definition across translation units */
+
+    #define CC_MO_RELAXED       0
+    #define CC_MO_ACQUIRE       2
+    #define CC_MO_RELEASE       3
+    #define CC_MO_ACQ_REL       4
+    #define CC_MO_SEQ_CST       5
 
     #define WINDOWS_DEFAULT_GUARD_SIZE  4096
 
@@ -54,300 +126,4953 @@
 #define CC_TH_JOINABLE      0
 #define CC_TH_DETACHED      1
 
+/* upper bound for the adaptive spin phase of "cc_mtx" before parking the thread */
+#ifndef CC_MTX_SPIN_MAX
+    #define CC_MTX_SPIN_MAX     200
+#endif
+
+typedef struct {
+    uint8_t state;  /* 0: not run, 1: running, 2: running with parked waiters, 3: done */
+} cc_once;
+
+#define CC_ONCE_INIT        { 0 }
+
+/* fibers tell the sanitizers about their stack switches */
+#if defined(__SANITIZE_ADDRESS__)
+    #define CC__ASAN
+#endif
+#if defined(__SANITIZE_THREAD__)
+    #define CC__TSAN
+#endif
+#if defined(__has_feature)
+    #if __has_feature(address_sanitizer) && !defined(CC__ASAN)
+        #define CC__ASAN
+    #endif
+    #if __has_feature(thread_sanitizer) && !defined(CC__TSAN)
+        #define CC__TSAN
+    #endif
+#endif
+
+typedef struct {
+    uint32_t state;  /* 0: unlocked, 1: locked, 2: locked and (possibly) contended */
+    uint32_t spin;   /* running estimate of the spins needed to acquire the lock */
+} cc_mtx;
+
+#define CC_MTX_INITIALIZER  { 0, 0 }
+
+typedef struct {
+    uint32_t seq;      /* bumped by every signal / broadcast, waiters sleep on it */
+    uint32_t waiters;  /* threads blocked in "cc_cond_wait", lets signalers skip the syscall */
+    void *p_mtx;       /* "cc_mtx" of the waiters, broadcast requeues them onto it */
+} cc_cond;
+
+#define CC_COND_INITIALIZER { 0, 0, NULL }
+
+typedef struct {
+    uint32_t count;        /* available permits, waiters sleep on it */
+    uint32_t waiters;      /* threads blocked in "cc_sem_wait*", posters skip the syscall when 0 */
+    uint32_t big_waiters;  /* blocked threads asking for more than one permit */
+} cc_sem;
+
+#define CC_SEM_INITIALIZER(value)   { (value), 0, 0 }
+
+#ifndef CC_CACHE_LINE_SIZE
+    #define CC_CACHE_LINE_SIZE  64
+#endif
+
+/* buckets of the hashed wait table ("cc_wait64", and every wait on POSIX systems without futex) */
+#ifndef CC_WAIT_TABLE_SIZE
+    #define CC_WAIT_TABLE_SIZE  256
+#endif
+
+/* buckets of the parking lot, the wait queues of one byte objects ("cc_lock", "cc_event", "cc_once") */
+#ifndef CC_PARK_TABLE_SIZE
+    #define CC_PARK_TABLE_SIZE  256
+#endif
+
+/* one byte mutex, waiters park in the parking lot (bit 0: locked, bit 1: threads parked) */
+typedef struct {
+    uint8_t state;
+} cc_lock;
+
+#define CC_LOCK_INITIALIZER     { 0 }
+
+/* one byte manual-reset event (bit 0: set, bit 1: threads parked) */
+typedef struct {
+    uint8_t state;
+} cc_event;
+
+#define CC_EVENT_INITIALIZER    { 0 }
+
+/* queue node of "cc_mcs_lock" / "cc_clh_lock", each waiter spins on its own cache line */
+typedef struct cc__qnode {
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) struct cc__qnode *p_next;
+    uint32_t locked;                  /* 1: waiting (CLH: or holding), 2: waiting and parked */
+    struct cc__qnode *p_pool_next;    /* per-thread free list */
+} cc__qnode;
+
+typedef struct {
+    cc__qnode *p_tail;
+    cc__qnode *p_holder;  /* node of the current owner, only touched by it */
+} cc_mcs_lock;
+
+#define CC_MCS_LOCK_INITIALIZER     { NULL, NULL }
+
+typedef struct {
+    cc__qnode *p_tail;
+    cc__qnode *p_holder;  /* node of the current owner, only touched by it */
+    cc__qnode *p_pred;    /* node inherited from the predecessor, recycled on release */
+} cc_clh_lock;
+
+/* consecutive handoffs a "cc_cohort_lock" may do inside one NUMA node before releasing the global lock */
+#ifndef CC_COHORT_HANDOFF_MAX
+    #define CC_COHORT_HANDOFF_MAX   64
+#endif
+
+#ifndef CC_COHORT_MAX_NODES
+    #define CC_COHORT_MAX_NODES     64
+#endif
+
+/* one cache line per NUMA node, so handoffs inside a cohort never touch another socket's line */
+typedef struct {
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) cc_mcs_lock local;
+    uint32_t global_held;  /* the global lock was passed along inside this cohort */
+    uint32_t batch;        /* consecutive local handoffs */
+} cc__cohort_node;
+
+typedef struct {
+    cc_mtx global;
+    uint32_t handoff_max;
+    uint32_t holder_node;  /* cohort of the current owner, only touched by it */
+    uint32_t n_nodes;
+    uint32_t n_cpus;
+    uint32_t *p_cpu_node;  /* cpu -> NUMA node */
+    cc__cohort_node *p_nodes;
+} cc_cohort_lock;
+
+/* sequence lock: odd while a writer is inside, readers retry if it changed under them */
+typedef struct {
+    uint32_t seq;
+} cc_seqlock;
+
+#define CC_SEQLOCK_INITIALIZER  { 0 }
+
+/* number of reader indicators of a "cc_rwlock", threads are hashed onto them */
+#ifndef CC_RWLOCK_SLOTS
+    #define CC_RWLOCK_SLOTS     64
+#endif
+
+typedef struct {
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint32_t readers;
+} cc__rw_slot;
+
+typedef struct {
+    cc__rw_slot slots[CC_RWLOCK_SLOTS];
+    cc_mtx wr_mtx;    /* serializes writers */
+    uint32_t writer;  /* 0: no writer, 1: writer active, 2: writer active and readers parked */
+} cc_rwlock;
+
+#define CC_BARRIER_AUTO             0  /* central up to CC_BARRIER_CENTRAL_MAX participants, dissemination above */
+#define CC_BARRIER_CENTRAL          1
+#define CC_BARRIER_DISSEMINATION    2
+
+#define CC_BARRIER_SERIAL_THREAD    -1
+
+#ifndef CC_BARRIER_CENTRAL_MAX
+    #define CC_BARRIER_CENTRAL_MAX  8
+#endif
+
+/* per participant state of a dissemination barrier, one flag per round */
+typedef struct {
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint32_t flags[32];
+    uint32_t episode;
+} cc__barrier_node;
+
+typedef struct {
+    int algorithm;
+    uint32_t count;
+    uint32_t rounds;
+    uint32_t arrived;    /* central: threads arrived in the current episode */
+    uint32_t episode;    /* central: bumped when everybody arrived, waiters sleep on it */
+    uint32_t sleepers;   /* central: threads parked on "episode" */
+    cc__barrier_node *p_nodes;
+} cc_barrier;
+
+/* capacity of the per worker Chase-Lev deque of a "cc_pool" (power of two), overflow goes to the shared queue */
+#ifndef CC_POOL_DEQUE_SIZE
+    #define CC_POOL_DEQUE_SIZE  4096
+#endif
+
+/* task nodes a worker keeps for reuse instead of handing them back to the allocator */
+#ifndef CC_POOL_TASK_CACHE
+    #define CC_POOL_TASK_CACHE  256
+#endif
+
+/* empty steal rounds of an idle worker before it goes to sleep */
+#ifndef CC_POOL_SPIN_MAX
+    #define CC_POOL_SPIN_MAX    64
+#endif
+
+/* stack of the workers of an elastic pool, see "cc_pool_init_elastic" */
+#ifndef CC_POOL_STACK_SIZE
+    #define CC_POOL_STACK_SIZE  (256 * 1024)
+#endif
+
+struct cc_task_group;
+
+typedef struct cc__task {
+    void (*func)(void *arg);
+    void *arg;
+    struct cc_task_group *p_group;  /* signalled when the task has run, may be NULL */
+    struct cc__task *p_next;        /* shared queue / free list link */
+} cc__task;
+
+struct cc_pool;
+
+typedef struct {
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint64_t top;     /* thieves take from the top */
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint64_t bottom;  /* the owner pushes and pops at the bottom */
+    void **p_buf;
+    cc__task *p_free;  /* cached task nodes, owner only */
+    uint32_t n_free;
+    uint32_t rng;      /* victim selection */
+    uint32_t state;    /* CC__POOL_SLOT_*, whether "th" runs or awaits a join */
+    cc_th th;
+    struct cc_pool *p_pool;
+} cc__pool_worker;
+
+typedef struct cc_pool {
+    uint32_t n_workers;     /* worker slots, the maximum of an elastic pool */
+    uint32_t min_workers;   /* below "n_workers": elastic */
+    uint32_t idle_ms;       /* idle time before an elastic worker above the minimum exits */
+    uint32_t stop;
+    size_t stack_size;      /* 0: default thread stacks */
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint32_t pending;  /* submitted tasks not finished yet */
+    uint32_t waiters;                                  /* threads blocked in "cc_pool_wait" */
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint32_t sleep_seq;  /* bumped to wake idle workers, they sleep on it */
+    uint32_t sleepers;
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint32_t n_live;     /* running workers */
+    cc_mtx grow_mtx;                                     /* serializes spawns and shutdown */
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) cc_mtx inject_mtx;   /* shared queue of tasks submitted from outside */
+    uint32_t n_inject;
+    cc__task *p_inject_head;
+    cc__task *p_inject_tail;
+    cc__pool_worker *p_workers;
+} cc_pool;
+
+/* bit of "cc_task_group.pending" telling the last task to wake the waiters */
+#define CC__TASK_GROUP_WAITING  0x80000000U
+
+/* fork-join scope over a "cc_pool": the tasks run through it are waited for together */
+typedef struct cc_task_group {
+    cc_pool *p_pool;
+    uint32_t pending;  /* unfinished tasks | CC__TASK_GROUP_WAITING */
+} cc_task_group;
+
+/* anything able to run "func(arg)" later, see "cc_pool_executor" */
+typedef struct {
+    int (*submit)(void *ctx, void (*func)(void *arg), void *arg);
+    void *ctx;
+} cc_executor;
+
+struct cc_continuation;
+
+/* result slot shared by a "cc_promise" and its consumers, owned by the caller (no allocation) */
+typedef struct cc_future {
+    uint32_t state;      /* CC__FUTURE_* bits */
+    uint32_t remaining;  /* inputs left while the future is the output of "cc_future_when_all/any" */
+    int error;
+    void *value;
+    struct cc_continuation *p_conts;  /* registered continuations, a sentinel once ready */
+} cc_future;
+
+typedef struct {
+    cc_future *p_future;
+} cc_promise;
+
+/* continuation slot of "cc_future_then" / "cc_future_when_all" / "cc_future_when_any", owned by the caller */
+typedef struct cc_continuation {
+    int (*func)(cc_future *p_src, void *arg, void **p_result);
+    void *arg;
+    const cc_executor *p_exec;  /* NULL: run inline on the thread completing the source */
+    cc_future *p_src;
+    cc_future *p_dst;           /* completed with the result of "func", may be NULL */
+    struct cc_continuation *p_next;
+} cc_continuation;
+
+#define CC_PARALLEL_STATIC      0  /* equal blocks, one per thread */
+#define CC_PARALLEL_DYNAMIC     1  /* chunks of "grain" iterations claimed on demand */
+#define CC_PARALLEL_GUIDED      2  /* chunks shrinking with the remaining work, never below "grain" */
+#define CC_PARALLEL_AUTO        3  /* dynamic, with the grain derived from the measured cost of an iteration */
+
+/* duration an auto-sized chunk aims for, long enough to amortize claiming it */
+#ifndef CC_PARALLEL_CHUNK_NS
+    #define CC_PARALLEL_CHUNK_NS    20000
+#endif
+
+typedef struct {
+    void (*body)(size_t begin, size_t end, void *arg);
+    void *arg;
+    int schedule;
+    uint32_t n_parts;   /* threads taking part (static: number of blocks) */
+    uint32_t next_part; /* static: next block to claim */
+    uint64_t begin;
+    uint64_t end;
+    uint64_t grain;
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint64_t next;  /* dynamic / guided: first unclaimed iteration */
+} cc__parallel_for;
+
+#define CC_SCAN_INCLUSIVE       0  /* out[i] = in[0] + ... + in[i] */
+#define CC_SCAN_EXCLUSIVE       1  /* out[i] = identity + in[0] + ... + in[i - 1] */
+
+/* blocks per thread of "cc_parallel_reduce" / "cc_parallel_scan", so an uneven block doesn't stall the rest */
+#ifndef CC_PARALLEL_BLOCKS
+    #define CC_PARALLEL_BLOCKS      4
+#endif
+
+/* shared state of the blocked reduce / scan, every block has its partial in its own cache line(s) */
+typedef struct {
+    size_t begin;
+    size_t end;
+    size_t block_len;
+    size_t size;
+    size_t stride;             /* bytes between two partials: room for partial + scratch, rounded to cache lines */
+    unsigned char *p_partials;
+    const void *p_identity;
+    const unsigned char *p_in;
+    unsigned char *p_out;
+    void (*map)(size_t first, size_t last, void *p_acc, void *arg);
+    void (*combine)(void *p_acc, const void *p_other, void *arg);
+    void *arg;
+    int mode;
+} cc__parallel_blocks;
+
+/* inputs up to this many items are sorted by the calling thread alone */
+#ifndef CC_SORT_SEQUENTIAL_MAX
+    #define CC_SORT_SEQUENTIAL_MAX  8192
+#endif
+
+/* samples taken per bucket to choose the splitters of "cc_parallel_sort" */
+#ifndef CC_SORT_OVERSAMPLE
+    #define CC_SORT_OVERSAMPLE      32
+#endif
+
+#define CC__RADIX_DIGITS        256  /* "cc_parallel_radix_sort" sorts one byte of the key per pass */
+
+/* shared state of the parallel sorts, blocks only write to their own row of "p_counts" */
+typedef struct {
+    unsigned char *p_src;
+    unsigned char *p_dst;
+    size_t n;
+    size_t size;
+    size_t block_len;
+    size_t n_buckets;
+    size_t *p_counts;          /* per block and bucket: item count, then first destination slot */
+    size_t *p_bucket_start;    /* sample sort: first slot of every bucket, plus the end */
+    unsigned char *p_splitters;
+    int (*compare)(const void *p_a, const void *p_b);
+    uint64_t (*key)(const void *p_item);
+    unsigned shift;
+} cc__parallel_sort;
+
+/* priority bands of "cc_prio_pool", band 0 runs first */
+#ifndef CC_PRIO_BANDS
+    #define CC_PRIO_BANDS       4
+#endif
+#define CC_PRIO_HIGHEST     0
+#define CC_PRIO_LOWEST      (CC_PRIO_BANDS - 1)
+
+typedef struct cc__prio_task {
+    void (*func)(void *arg);
+    void *arg;
+    uint64_t queued_ns;
+    struct cc__prio_task *p_next;
+} cc__prio_task;
+
+typedef struct {
+    struct cc_prio_pool *p_pool;
+    cc__prio_task *p_head;
+    cc__prio_task *p_tail;
+} cc__prio_band;
+
+typedef struct cc_prio_pool {
+    cc_mtx mtx;
+    cc_cond work_cond;          /* idle workers */
+    cc_cond idle_cond;          /* "cc_prio_pool_wait" callers */
+    cc__prio_band bands[CC_PRIO_BANDS];
+    cc__prio_task *p_free;
+    uint32_t n_free;
+    uint32_t n_workers;
+    uint32_t pending;           /* queued and running tasks */
+    uint32_t stop;
+    uint64_t aging_ns;          /* a queued task moves up one band per period, 0: strict priorities */
+    cc_th *p_threads;
+} cc_prio_pool;
+
+/* timing wheel geometry: CC_TIMER_LEVELS levels of 64 slots cover 64^CC_TIMER_LEVELS ticks */
+#ifndef CC_TIMER_LEVELS
+    #define CC_TIMER_LEVELS     6
+#endif
+#ifndef CC_TIMER_TICK_MS
+    #define CC_TIMER_TICK_MS    1
+#endif
+#define CC__TIMER_SLOT_BITS     6
+#define CC__TIMER_SLOTS         (1U << CC__TIMER_SLOT_BITS)
+
+/* intrusive timer, owned by the caller and linked into the wheel while pending */
+typedef struct cc_timer {
+    struct cc_timer *p_next;
+    struct cc_timer **pp_prev;
+    void (*func)(void *arg);
+    void *arg;
+    uint64_t expires;           /* tick */
+    uint64_t period;            /* ticks, 0: one shot */
+    uint32_t state;
+    uint32_t slot;              /* level * CC__TIMER_SLOTS + index, or CC__TIMER_NO_SLOT */
+    struct cc_timer_wheel *p_wheel;
+} cc_timer;
+
+typedef struct cc_timer_wheel {
+    cc_mtx mtx;
+    cc_cond cond;
+    uint64_t start_ns;
+    uint64_t tick_ns;
+    uint64_t now;               /* next tick to expire */
+    uint64_t wake_tick;         /* tick the service thread sleeps until */
+    uint64_t occupied[CC_TIMER_LEVELS];
+    cc_timer *slots[CC_TIMER_LEVELS][CC__TIMER_SLOTS];
+    cc_timer *p_expired;
+    cc_timer *p_running;        /* timer whose callback runs, only compared once the callback started */
+    cc_cond done_cond;          /* "cc_timer_cancel_sync" callers waiting for a callback to return */
+    size_t n_pending;
+    uint32_t stop;
+    cc_th th;
+    cc_th_id th_id;
+} cc_timer_wheel;
+
+/* "cc_pipeline_stage.mode" */
+#define CC_PIPELINE_SERIAL_IN_ORDER     0  /* one item at a time, in input order */
+#define CC_PIPELINE_SERIAL_OUT_OF_ORDER 1  /* one item at a time, any order */
+#define CC_PIPELINE_PARALLEL            2  /* any number of items at once */
+
+/*
+    "func" gets the item from the previous stage and returns the one handed to the next, NULL drops it.
+    The first stage is the input: called with NULL, it returns the next item or NULL at the end of the stream.
+    "token" (below the in-flight bound) identifies the item's slot, e.g. to index preallocated buffers.
+*/
+typedef struct {
+    void *(*func)(void *p_item, uint32_t token, void *arg);
+    void *arg;
+    int mode;
+} cc_pipeline_stage;
+
+struct cc__pipeline;
+
+typedef struct cc__pipeline_token {
+    void *p_item;
+    uint64_t seq;               /* input order */
+    uint32_t index;
+    uint32_t stage;             /* next stage to run */
+    int acquired;               /* resumed while already owning its serial stage */
+    struct cc__pipeline *p_pipeline;
+    struct cc__pipeline_token *p_next;
+} cc__pipeline_token;
+
+typedef struct {
+    cc_mtx mtx;
+    uint32_t busy;
+    uint64_t next_seq;                  /* in order: the only item allowed in (input: the next one read) */
+    cc__pipeline_token **pp_parked;     /* in order: waiting tokens by "seq % max_tokens" */
+    cc__pipeline_token *p_head;         /* out of order: waiting tokens, FIFO */
+    cc__pipeline_token *p_tail;
+} cc__pipeline_serial;
+
+typedef struct cc__pipeline {
+    const cc_pipeline_stage *p_stages;
+    cc__pipeline_serial *p_serial;
+    cc__pipeline_token *p_tokens;
+    cc__pipeline_token *p_free;         /* tokens not in flight, guarded by the input stage */
+    uint32_t n_stages;
+    uint32_t max_tokens;
+    uint32_t done;                      /* the input returned NULL */
+    cc_task_group group;
+} cc__pipeline;
+
+struct cc_graph;
+
+typedef struct cc_graph_node {
+    void (*func)(void *arg);
+    void *arg;
+    uint32_t n_deps;                    /* predecessors */
+    uint32_t pending;                   /* predecessors left in the current run, back at "n_deps" between runs */
+    uint32_t n_succ;
+    uint32_t cap_succ;
+    struct cc_graph_node **pp_succ;
+    struct cc_graph *p_graph;
+} cc_graph_node;
+
+/* task graph declared once and run any number of times */
+typedef struct cc_graph {
+    cc_graph_node **pp_nodes;
+    uint32_t n_nodes;
+    uint32_t cap_nodes;
+    uint32_t n_run;                     /* nodes run so far in the current run */
+    cc_task_group group;
+} cc_graph;
+
+/* usable stack of a fiber, a guard page sits below it (POSIX) */
+#ifndef CC_FIBER_STACK_SIZE
+    #define CC_FIBER_STACK_SIZE     (64 * 1024)
+#endif
+
+/* stacks of finished fibers kept for the next ones */
+#ifndef CC_FIBER_STACK_CACHE
+    #define CC_FIBER_STACK_CACHE    1024
+#endif
+
+typedef struct {
+#if defined(CC__FIBER_ASM)
+    void *p_sp;
+#elif defined(CC_POSIX)
+    ucontext_t uc;
+#elif defined(CC_WINDOWS)
+    void *p_fiber;
+#endif
+} cc__fiber_ctx;
+
+struct cc_fiber;
+
+/* stack with a saved context, it runs fibers one after the other and is cached in between */
+typedef struct cc__fiber_stack {
+    cc__fiber_ctx ctx;
+    cc__fiber_ctx *p_carrier;       /* context of the thread that resumed it last */
+    struct cc_fiber *p_fiber;       /* fiber it runs */
+    void *p_mem;                    /* mapping, guard page included */
+    size_t size;
+    struct cc__fiber_stack *p_next; /* cache link */
+#if defined(CC__TSAN)
+    void *p_tsan_fiber;
+    void *p_tsan_carrier;
+#endif
+#if defined(CC__ASAN)
+    void *p_asan_fake;
+    const void *p_asan_carrier;
+    size_t asan_carrier_size;
+#endif
+} cc__fiber_stack;
+
+typedef struct cc_fiber {
+    void (*func)(void *arg);
+    void *arg;
+    cc_pool *p_pool;                /* its carrier threads */
+    cc__fiber_stack *p_stack;
+    struct cc_fiber *p_joiner;      /* fiber blocked in "cc_fiber_join", CC__FIBER_JOINED once finished */
+    struct cc_fiber *p_target;      /* fiber it joins */
+    uint32_t action;                /* what the carrier does once the fiber switched out */
+    uint32_t done;
+} cc_fiber;
+
+/*
+    Stackless coroutine, the resume point of a function written between CC_CO_BEGIN and CC_CO_END.
+    Locals do not survive a suspension, keep what must in the caller's struct next to the cc_co.
+    The body is one switch on the resume point, so CC_CO_YIELD and CC_CO_AWAIT must not sit inside a switch
+    of its own: their case label would belong to that inner switch and resuming ends the coroutine instead.
+
+        switch (p_s->kind) {                        // wrong: the resume lands on the outer "default"
+        case MSG_DATA: CC_CO_YIELD(&p_s->co); ...
+        }
+
+        if (MSG_DATA == p_s->kind) {                // right
+            CC_CO_YIELD(&p_s->co); ...
+        }
+*/
+typedef struct {
+    uint32_t line;                  /* 0 before the first call */
+} cc_co;
+
+#define CC_CO_INIT          { 0 }
+
+#define CC_CO_PENDING       0       /* suspended, call again to resume */
+#define CC_CO_DONE          1
+
+#define CC__CO_FINISHED     UINT32_MAX
+
+/* opens the body of a coroutine function returning int, resuming is a jump to the saved line */
+#define CC_CO_BEGIN(p_co)   switch ((p_co)->line) { default: return CC_CO_DONE; case 0:
+
+/* suspends until the next call. NOTE: at most one CC_CO_YIELD or CC_CO_AWAIT per source line */
+#define CC_CO_YIELD(p_co)   do { (p_co)->line = __LINE__; return CC_CO_PENDING; case __LINE__:; } while (0)
+
+/* suspends until "cond" holds, it is re-evaluated on every call */
+#define CC_CO_AWAIT(p_co, cond)     while (!(cond)) CC_CO_YIELD(p_co)
+
+/* finishes the coroutine early */
+#define CC_CO_RETURN(p_co)  do { (p_co)->line = CC__CO_FINISHED; return CC_CO_DONE; } while (0)
+
+#define CC_CO_END(p_co)     } (p_co)->line = CC__CO_FINISHED; return CC_CO_DONE
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-
-static inline int cc_th_attr_destroy(cc_th_attr *p_attr) {
+/* NOTE: Timeouts are absolute deadlines on the monotonic clock, so they are not affected by wall-clock changes */
+static inline int cc_time_monotonic(struct timespec *p_ts) {
 #if defined(CC_POSIX)
-    return pthread_attr_destroy(p_attr);
-#elif defined(CC_WINDOWS)  /* nop */
-    (void)p_attr;
+    return clock_gettime(CLOCK_MONOTONIC, p_ts);
+#elif defined(CC_WINDOWS)
+    LARGE_INTEGER freq, cnt;
+    if (!p_ts) return -1;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&cnt);
+    p_ts->tv_sec = (time_t)(cnt.QuadPart / freq.QuadPart);
+    p_ts->tv_nsec = (long)((cnt.QuadPart % freq.QuadPart) * 1000000000LL / freq.QuadPart);
     return 0;
 #endif
 }
 
-static inline int cc_th_attr_getdetachstate(cc_th_attr *p_attr, int *p_detachstate) {
+static inline void cc_time_add_ms(struct timespec *p_ts, unsigned long ms) {
+    p_ts->tv_sec += (time_t)(ms / 1000);
+    p_ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (p_ts->tv_nsec >= 1000000000L) {
+        p_ts->tv_sec++;
+        p_ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static inline uint64_t cc__time_now_ns(void) {
+    struct timespec now;
+    cc_time_monotonic(&now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/* nanoseconds left before "p_abstime" (negative once expired) */
+static inline long long cc__time_left_ns(const struct timespec *p_abstime) {
+    struct timespec now;
+    cc_time_monotonic(&now);
+    return (long long)(p_abstime->tv_sec - now.tv_sec) * 1000000000LL + (long long)(p_abstime->tv_nsec - now.tv_nsec);
+}
+
+/*
+    Atomics: typed load / store / exchange / cas / fetch_add with an explicit memory order (CC_MO_*),
+    "cas" is the strong compare-and-swap and updates "*p_expected" on failure.
+    NOTE: on Windows every operation is a full barrier (Interlocked*), "order" is ignored.
+*/
+static inline uint32_t cc_atomic_load_u32(uint32_t *p, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_getdetachstate(p_attr, p_detachstate);
+    return __atomic_load_n(p, order);
 #elif defined(CC_WINDOWS)
-    if (!p_detachstate || !p_attr) return -1;
-    *(p_detachstate) = p_attr->detach_state;
-    return 0;
+    (void)order;
+    return (uint32_t)InterlockedOr((volatile LONG *)p, 0);
 #endif
 }
 
-static inline int cc_th_attr_getguardsize(cc_th_attr *p_attr, size_t *p_guardsize) {
+static inline void cc_atomic_store_u32(uint32_t *p, uint32_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_getguardsize(p_attr, p_guardsize);
+    __atomic_store_n(p, val, order);
 #elif defined(CC_WINDOWS)
-    if (!p_guardsize || !p_attr) return -1;
-    *(p_guardsize) = WINDOWS_DEFAULT_GUARD_SIZE;
-    return 0;
+    (void)order;
+    InterlockedExchange((volatile LONG *)p, (LONG)val);
 #endif
 }
 
-static inline int cc_th_attr_getinheritsched(cc_th_attr *p_attr, int *p_inheritsched) {
+static inline uint32_t cc_atomic_exchange_u32(uint32_t *p, uint32_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_getinheritsched(p_attr, p_inheritsched);
+    return __atomic_exchange_n(p, val, order);
 #elif defined(CC_WINDOWS)
-    if (!p_inheritsched || !p_attr) return -1;
-    *(p_inheritsched) = p_attr->inherit_sched;
-    return 0;
+    (void)order;
+    return (uint32_t)InterlockedExchange((volatile LONG *)p, (LONG)val);
 #endif
 }
 
-static inline int cc_th_attr_getschedpolicy(cc_th_attr *p_attr, int *p_schedpolicy) {
+static inline int cc_atomic_cas_u32(uint32_t *p, uint32_t *p_expected, uint32_t desired, int success, int failure) {
 #if defined(CC_POSIX)
-    return pthread_attr_getschedpolicy(p_attr, p_schedpolicy);
+    return __atomic_compare_exchange_n(p, p_expected, desired, 0, success, failure);
 #elif defined(CC_WINDOWS)
-    if (!p_schedpolicy || ! p_attr) return -1;
-    *(p_schedpolicy) = p_attr->sched_policy;
+    uint32_t prev = (uint32_t)InterlockedCompareExchange((volatile LONG *)p, (LONG)desired, (LONG)*p_expected);
+    (void)success;
+    (void)failure;
+    if (prev == *p_expected) return 1;
+    *p_expected = prev;
     return 0;
 #endif
 }
 
-static inline int cc_th_attr_getscope(cc_th_attr *p_attr, int *p_contentionscope) {
+static inline uint32_t cc_atomic_fetch_add_u32(uint32_t *p, uint32_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_getscope(p_attr, p_contentionscope);
+    return __atomic_fetch_add(p, val, order);
 #elif defined(CC_WINDOWS)
-    if (!p_contentionscope || !p_attr) return -1;
-    *(p_contentionscope) = p_attr->contention_scope;
-    return 0;
+    (void)order;
+    return (uint32_t)InterlockedExchangeAdd((volatile LONG *)p, (LONG)val);
 #endif
 }
 
-static inline int cc_th_attr_getstacksize(cc_th_attr *p_attr, size_t *p_stacksize) {
+static inline uint32_t cc_atomic_fetch_sub_u32(uint32_t *p, uint32_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_getstacksize(p_attr, p_stacksize);
+    return __atomic_fetch_sub(p, val, order);
 #elif defined(CC_WINDOWS)
-    if (!p_stacksize || !p_attr) return -1;
-    *(p_stacksize) = p_attr->stack_size;
-    return 0;
+    (void)order;
+    return (uint32_t)InterlockedExchangeAdd((volatile LONG *)p, -(LONG)val);
 #endif
 }
 
-static inline int cc_th_attr_init(cc_th_attr *p_attr) {
+static inline uint8_t cc_atomic_load_u8(uint8_t *p, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_init(p_attr);
+    return __atomic_load_n(p, order);
 #elif defined(CC_WINDOWS)
-    if (!p_attr) return -1;
-    p_attr->detach_state = CC_TH_JOINABLE;
-    p_attr->stack_size = 0;
-    p_attr->inherit_sched = CC_EXPLICIT_SCHED;  /* default explicit scheduling */
-    p_attr->contention_scope = CC_SCOPE_SYSTEM;  /* default to system scope for Windows */ 
-    return 0;
+    (void)order;
+    return (uint8_t)_InterlockedOr8((volatile char *)p, 0);
 #endif
 }
 
-static inline int cc_th_attr_setdetachstate(cc_th_attr *p_attr, int detachstate) {
+static inline void cc_atomic_store_u8(uint8_t *p, uint8_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_setdetachstate(p_attr, detachstate);
+    __atomic_store_n(p, val, order);
 #elif defined(CC_WINDOWS)
-    if (!p_attr) return -1;
-    p_attr->detach_state = detachstate;
-    return 0;
+    (void)order;
+    _InterlockedExchange8((volatile char *)p, (char)val);
 #endif
 }
 
-static inline int cc_th_attr_setguardsize(cc_th_attr *p_attr, size_t guardsize) {
+static inline uint8_t cc_atomic_exchange_u8(uint8_t *p, uint8_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_setguardsize(p_attr, guardsize);
-#elif defined(CC_WINDOWS)  /* nop */
-    (void)p_attr;
-    (void)guardsize;
-    return 0;
+    return __atomic_exchange_n(p, val, order);
+#elif defined(CC_WINDOWS)
+    (void)order;
+    return (uint8_t)_InterlockedExchange8((volatile char *)p, (char)val);
 #endif
 }
 
-static inline int cc_th_attr_setinheritsched(cc_th_attr *p_attr, int inheritsched) {
+static inline int cc_atomic_cas_u8(uint8_t *p, uint8_t *p_expected, uint8_t desired, int success, int failure) {
 #if defined(CC_POSIX)
-    return pthread_attr_setinheritsched(p_attr, inheritsched);
+    return __atomic_compare_exchange_n(p, p_expected, desired, 0, success, failure);
 #elif defined(CC_WINDOWS)
-    if (!p_attr) return -1;
-    p_attr->inherit_sched = inheritsched;
+    uint8_t prev = (uint8_t)_InterlockedCompareExchange8((volatile char *)p, (char)desired, (char)*p_expected);
+    (void)success;
+    (void)failure;
+    if (prev == *p_expected) return 1;
+    *p_expected = prev;
     return 0;
 #endif
 }
 
-static inline int cc_th_attr_setschedpolicy(cc_th_attr *p_attr, int schedpolicy) {
+static inline uint64_t cc_atomic_load_u64(uint64_t *p, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_setschedpolicy(p_attr, schedpolicy);
+    return __atomic_load_n(p, order);
 #elif defined(CC_WINDOWS)
-    if (!p_attr) return -1;
-    p_attr->sched_policy = schedpolicy;
-    return 0;
+    (void)order;
+    return (uint64_t)InterlockedOr64((volatile LONG64 *)p, 0);
 #endif
 }
 
-static inline int cc_th_attr_setscope(cc_th_attr *p_attr, int contentionscope) {
+static inline void cc_atomic_store_u64(uint64_t *p, uint64_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_setscope(p_attr, contentionscope);
+    __atomic_store_n(p, val, order);
 #elif defined(CC_WINDOWS)
-    if (!p_attr) return -1;
-    p_attr->contention_scope = contentionscope;
-    return 0;
+    (void)order;
+    InterlockedExchange64((volatile LONG64 *)p, (LONG64)val);
 #endif
 }
 
-static inline int cc_th_attr_setstacksize(cc_th_attr *p_attr, size_t stacksize) {
+static inline uint64_t cc_atomic_exchange_u64(uint64_t *p, uint64_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_attr_setstacksize(p_attr, stacksize);
+    return __atomic_exchange_n(p, val, order);
 #elif defined(CC_WINDOWS)
-    if (!p_attr) return -1;
-    p_attr->stack_size = stacksize;
-    return 0;
+    (void)order;
+    return (uint64_t)InterlockedExchange64((volatile LONG64 *)p, (LONG64)val);
 #endif
 }
 
-static inline int cc_th_create(cc_th *p_th, cc_th_attr *p_attr, void *(*th_func)(void *), void *arg) {
+static inline int cc_atomic_cas_u64(uint64_t *p, uint64_t *p_expected, uint64_t desired, int success, int failure) {
 #if defined(CC_POSIX)
-    return pthread_create(p_th, p_attr, th_func, arg);
+    return __atomic_compare_exchange_n(p, p_expected, desired, 0, success, failure);
 #elif defined(CC_WINDOWS)
-    SIZE_T actual_stacksize = 0;
-    int initial_thread_priority = THREAD_PRIORITY_NORMAL;
-
-    if (p_attr) {
-        if (p_attr->stack_size > 0) actual_stacksize = (SIZE_T)p_attr->stack_size;
-        if (p_attr->inherit_sched == CC_INHERIT_SCHED) {
-            initial_thread_priority = GetThreadPriority(GetCurrentThread());
-            if (initial_thread_priority == THREAD_PRIORITY_ERROR_RETURN)
-                initial_thread_priority = THREAD_PRIORITY_NORMAL;
-        }
-    }
-
-    *p_th = CreateThread(
-        NULL,
-        actual_stacksize,
-        (LPTHREAD_START_ROUTINE)th_func,
-        (LPVOID)arg,
-        CREATE_SUSPENDED,
-        NULL
-    );
-    if (!*p_th) return -1;
-
-    if (initial_thread_priority != THREAD_PRIORITY_NORMAL)
-        SetThreadPriority(*p_th, initial_thread_priority);
-    
-    /* resume thread after setting properties */
-    ResumeThread(*p_th);
-
-    if (p_attr && CC_TH_DETACHED == p_attr->detach_state) {
-        if (!CloseHandle(*p_th)) return -2;
-        *p_th = NULL;
-    }
+    uint64_t prev = (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)p, (LONG64)desired, (LONG64)*p_expected);
+    (void)success;
+    (void)failure;
+    if (prev == *p_expected) return 1;
+    *p_expected = prev;
     return 0;
 #endif
 }
 
-static inline int cc_th_detach(cc_th *p_th) {
+static inline uint64_t cc_atomic_fetch_add_u64(uint64_t *p, uint64_t val, int order) {
 #if defined(CC_POSIX)
-    if (!p_th) return -1;
-    return pthread_detach(*p_th);
+    return __atomic_fetch_add(p, val, order);
 #elif defined(CC_WINDOWS)
-    if (!p_th) return -1;
-    if (!*p_th) return 0;
-    if (!CloseHandle(*p_th)) return -2;
-    *p_th = NULL;
-    return 0;
+    (void)order;
+    return (uint64_t)InterlockedExchangeAdd64((volatile LONG64 *)p, (LONG64)val);
 #endif
 }
 
-static inline int cc_th_equal_id(cc_th_id id1, cc_th_id id2) {
+static inline uint64_t cc_atomic_fetch_sub_u64(uint64_t *p, uint64_t val, int order) {
 #if defined(CC_POSIX)
-    return pthread_equal(id1, id2);
+    return __atomic_fetch_sub(p, val, order);
 #elif defined(CC_WINDOWS)
-    return (id1 == id2);
+    (void)order;
+    return (uint64_t)InterlockedExchangeAdd64((volatile LONG64 *)p, -(LONG64)val);
 #endif
 }
 
-static inline void cc_th_exit(void *retval) {
+static inline void *cc_atomic_load_ptr(void **p, int order) {
 #if defined(CC_POSIX)
-    pthread_exit(retval);
+    return __atomic_load_n(p, order);
 #elif defined(CC_WINDOWS)
-    /* NOTE: retval should be a small integer status code. Code doesn't work for words larger than DWORD_MAX */
-    ExitThread((DWORD)(ULONG_PTR)retval);
+    (void)order;
+    return InterlockedCompareExchangePointer((PVOID volatile *)p, NULL, NULL);
 #endif
 }
 
-static inline int cc_th_join(cc_th th, void **retval) {
+static inline void cc_atomic_store_ptr(void **p, void *val, int order) {
 #if defined(CC_POSIX)
-    return pthread_join(th, retval);
+    __atomic_store_n(p, val, order);
 #elif defined(CC_WINDOWS)
-    DWORD exit_code;
-    DWORD wait_result = WaitForSingleObject(th, INFINITE);
+    (void)order;
+    InterlockedExchangePointer((PVOID volatile *)p, val);
+#endif
+}
 
-    if (WAIT_OBJECT_0 == wait_result) {
-        if (GetExitCodeThread(th, &exit_code)) {
-            if (retval != NULL) *retval = (void*)(ULONG_PTR)exit_code;
-            if (!CloseHandle(th)) return -2;
-            return 0;
+static inline void *cc_atomic_exchange_ptr(void **p, void *val, int order) {
+#if defined(CC_POSIX)
+    return __atomic_exchange_n(p, val, order);
+#elif defined(CC_WINDOWS)
+    (void)order;
+    return InterlockedExchangePointer((PVOID volatile *)p, val);
+#endif
+}
+
+static inline int cc_atomic_cas_ptr(void **p, void **p_expected, void *desired, int success, int failure) {
+#if defined(CC_POSIX)
+    return __atomic_compare_exchange_n(p, p_expected, desired, 0, success, failure);
+#elif defined(CC_WINDOWS)
+    void *prev = InterlockedCompareExchangePointer((PVOID volatile *)p, desired, *p_expected);
+    (void)success;
+    (void)failure;
+    if (prev == *p_expected) return 1;
+    *p_expected = prev;
+    return 0;
+#endif
+}
+
+static inline void cc_atomic_fence(int order) {
+#if defined(CC_POSIX)
+    __atomic_thread_fence(order);
+#elif defined(CC_WINDOWS)
+    (void)order;
+    MemoryBarrier();
+#endif
+}
+
+/* cache-line aligned allocations, release with "cc__aligned_free" */
+static inline void *cc__aligned_alloc(size_t size) {
+#if defined(CC_POSIX)
+    void *p_mem = NULL;
+    if (0 != posix_memalign(&p_mem, CC_CACHE_LINE_SIZE, size)) return NULL;
+    return p_mem;
+#elif defined(CC_WINDOWS)
+    return _aligned_malloc(size, CC_CACHE_LINE_SIZE);
+#endif
+}
+
+static inline void cc__aligned_free(void *p_mem) {
+#if defined(CC_POSIX)
+    free(p_mem);
+#elif defined(CC_WINDOWS)
+    _aligned_free(p_mem);
+#endif
+}
+
+static inline void cc__cpu_relax(void) {
+#if defined(CC_POSIX)
+    #if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+    #elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield" ::: "memory");
+    #else
+        __asm__ __volatile__("" ::: "memory");
+    #endif
+#elif defined(CC_WINDOWS)
+    YieldProcessor();
+#endif
+}
+
+/* gives the CPU to another ready thread, for waits that cannot park */
+static inline void cc__yield(void) {
+#if defined(CC_POSIX)
+    sched_yield();
+#elif defined(CC_WINDOWS)
+    SwitchToThread();
+#endif
+}
+
+#if defined(CC_POSIX)
+/*
+    Hashed wait table: 64-bit waits on Linux (the futex word is 32 bits) and every wait on POSIX systems
+    without futex park on the bucket of their address. Shared (weak) across translation units.
+*/
+typedef struct {
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint32_t seq;  /* Linux: bumped by every wake, waiters sleep on it */
+    uint32_t waiters;
+#if !defined(__linux__)
+    uint32_t init;  /* 0: uninitialized, 1: initializing, 2: ready */
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+#endif
+} cc__wait_bucket;
+
+CC__SHARED cc__wait_bucket cc__wait_table[CC_WAIT_TABLE_SIZE];
+
+static inline cc__wait_bucket *cc__wait_bucket_of(void *p_addr) {
+    uint64_t h = (uint64_t)(uintptr_t)p_addr * 0x9E3779B97F4A7C15ULL;
+    return &cc__wait_table[(h >> 32) % CC_WAIT_TABLE_SIZE];
+}
+#endif
+
+#if defined(CC_POSIX) && !defined(__linux__)
+static inline void cc__wait_bucket_ready(cc__wait_bucket *p_bucket) {
+    uint32_t state = 0;
+    if (2 == cc_atomic_load_u32(&p_bucket->init, CC_MO_ACQUIRE)) return;
+    if (cc_atomic_cas_u32(&p_bucket->init, &state, 1, CC_MO_ACQUIRE, CC_MO_ACQUIRE)) {
+        pthread_mutex_init(&p_bucket->mtx, NULL);
+        pthread_cond_init(&p_bucket->cond, NULL);
+        cc_atomic_store_u32(&p_bucket->init, 2, CC_MO_RELEASE);
+        return;
+    }
+    while (2 != cc_atomic_load_u32(&p_bucket->init, CC_MO_ACQUIRE)) cc__cpu_relax();
+}
+
+/* the value is checked under the bucket mutex, so a waker (store, then lock and broadcast) can't be missed */
+static inline int cc__wait_table_wait(void *p_addr, uint64_t expected, int wide, const struct timespec *p_abstime) {
+    cc__wait_bucket *p_bucket = cc__wait_bucket_of(p_addr);
+    struct timespec ts;
+    long long left;
+    uint64_t cur;
+    int ret = 0;
+
+    cc__wait_bucket_ready(p_bucket);
+    pthread_mutex_lock(&p_bucket->mtx);
+    cur = wide ? cc_atomic_load_u64((uint64_t *)p_addr, CC_MO_SEQ_CST) : cc_atomic_load_u32((uint32_t *)p_addr, CC_MO_SEQ_CST);
+    if (cur == expected) {
+        p_bucket->waiters++;
+        if (!p_abstime) pthread_cond_wait(&p_bucket->cond, &p_bucket->mtx);
+        else if ((left = cc__time_left_ns(p_abstime)) <= 0) ret = ETIMEDOUT;
+        else {
+            /* condition variables wait on the realtime clock here */
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += (time_t)(left / 1000000000LL);
+            ts.tv_nsec += (long)(left % 1000000000LL);
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            if (ETIMEDOUT == pthread_cond_timedwait(&p_bucket->cond, &p_bucket->mtx, &ts)) ret = ETIMEDOUT;
         }
-        else return -1;
+        p_bucket->waiters--;
     }
-    else if (WAIT_ABANDONED == wait_result) return -3;
-    else if (WAIT_TIMEOUT == wait_result) return -4;
-    else return -5;
-#endif    
+    pthread_mutex_unlock(&p_bucket->mtx);
+    return ret;
 }
 
-static inline void *cc_tls_get(cc_tls_key key) {
+/* buckets are shared between addresses, so every sleeper of the bucket is woken to re-check */
+static inline void cc__wait_table_wake(void *p_addr) {
+    cc__wait_bucket *p_bucket = cc__wait_bucket_of(p_addr);
+    cc__wait_bucket_ready(p_bucket);
+    pthread_mutex_lock(&p_bucket->mtx);
+    if (p_bucket->waiters) pthread_cond_broadcast(&p_bucket->cond);
+    pthread_mutex_unlock(&p_bucket->mtx);
+}
+#endif
+
+#if defined(CC_WINDOWS)
+static inline int cc__wait_on_address(void *p_addr, void *p_expected, SIZE_T size, const struct timespec *p_abstime) {
+    DWORD ms = INFINITE;
+    if (p_abstime) {
+        long long left = cc__time_left_ns(p_abstime);
+        if (left <= 0) return ETIMEDOUT;
+        ms = (DWORD)((left + 999999LL) / 1000000LL);
+    }
+    if (!WaitOnAddress((volatile VOID *)p_addr, p_expected, size, ms) && ERROR_TIMEOUT == GetLastError())
+        return ETIMEDOUT;
+    return 0;
+}
+#endif
+
+/*
+    Blocks while "*p_addr == expected" until woken or "p_abstime" (NULL: no timeout) expires, returns 0 or ETIMEDOUT.
+    Spurious wakeups are possible, callers always re-check their condition.
+    Maps to futex on Linux and WaitOnAddress on Windows, other POSIX systems use the hashed wait table.
+    NOTE: the waker must store the new value before calling "cc_wake_*".
+    NOTE: never inlined nor analysed (noipa): glibc declares "syscall" leaf, so GCC would otherwise assume a
+    blocking call leaves non-escaping statics untouched and keep them in registers across a "cc_cond_wait" loop.
+*/
+static CC__NOIPA int cc_wait(uint32_t *p_addr, uint32_t expected, const struct timespec *p_abstime) {
+#if defined(CC_POSIX) && defined(__linux__)
+    long ret = syscall(SYS_futex, p_addr, FUTEX_WAIT_BITSET_PRIVATE, expected, p_abstime, NULL, FUTEX_BITSET_MATCH_ANY);
+    if (-1 == ret && ETIMEDOUT == errno) return ETIMEDOUT;
+    return 0;
+#elif defined(CC_POSIX)
+    return cc__wait_table_wait(p_addr, expected, 0, p_abstime);
+#elif defined(CC_WINDOWS)
+    return cc__wait_on_address(p_addr, &expected, sizeof(expected), p_abstime);
+#endif
+}
+
+/* wakes up to "n" threads blocked on "p_addr" (INT_MAX: all of them) */
+static inline void cc__wake_n(uint32_t *p_addr, int n) {
+#if defined(CC_POSIX) && defined(__linux__)
+    syscall(SYS_futex, p_addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+#elif defined(CC_POSIX)
+    (void)n;
+    cc__wait_table_wake(p_addr);
+#elif defined(CC_WINDOWS)
+    if (1 == n) WakeByAddressSingle((PVOID)p_addr);
+    else WakeByAddressAll((PVOID)p_addr);
+#endif
+}
+
+static inline void cc_wake_one(uint32_t *p_addr) {
+    cc__wake_n(p_addr, 1);
+}
+
+static inline void cc_wake_all(uint32_t *p_addr) {
+    cc__wake_n(p_addr, INT_MAX);
+}
+
+/*
+    64-bit variant of "cc_wait". Native on Windows, elsewhere waiters park on the hashed wait table
+    (on Linux: a 32-bit futex per bucket, bumped by every wake of an address hashing there).
+*/
+static inline int cc_wait64(uint64_t *p_addr, uint64_t expected, const struct timespec *p_abstime) {
+#if defined(CC_POSIX) && defined(__linux__)
+    cc__wait_bucket *p_bucket = cc__wait_bucket_of(p_addr);
+    uint32_t seq;
+    int ret = 0;
+
+    cc_atomic_fetch_add_u32(&p_bucket->waiters, 1, CC_MO_SEQ_CST);
+    seq = cc_atomic_load_u32(&p_bucket->seq, CC_MO_SEQ_CST);
+    if (cc_atomic_load_u64(p_addr, CC_MO_SEQ_CST) == expected)
+        ret = cc_wait(&p_bucket->seq, seq, p_abstime);
+    cc_atomic_fetch_sub_u32(&p_bucket->waiters, 1, CC_MO_RELAXED);
+    return ret;
+#elif defined(CC_POSIX)
+    return cc__wait_table_wait(p_addr, expected, 1, p_abstime);
+#elif defined(CC_WINDOWS)
+    return cc__wait_on_address(p_addr, &expected, sizeof(expected), p_abstime);
+#endif
+}
+
+static inline void cc__wake64(uint64_t *p_addr, int all) {
+#if defined(CC_POSIX) && defined(__linux__)
+    cc__wait_bucket *p_bucket = cc__wait_bucket_of(p_addr);
+    (void)all;  /* the bucket futex is shared, every sleeper re-checks its own address */
+    cc_atomic_fetch_add_u32(&p_bucket->seq, 1, CC_MO_SEQ_CST);
+    if (0 != cc_atomic_load_u32(&p_bucket->waiters, CC_MO_SEQ_CST))
+        cc_wake_all(&p_bucket->seq);
+#elif defined(CC_POSIX)
+    (void)all;
+    cc__wait_table_wake(p_addr);
+#elif defined(CC_WINDOWS)
+    if (all) WakeByAddressAll((PVOID)p_addr);
+    else WakeByAddressSingle((PVOID)p_addr);
+#endif
+}
+
+static inline void cc_wake_one64(uint64_t *p_addr) {
+    cc__wake64(p_addr, 0);
+}
+
+static inline void cc_wake_all64(uint64_t *p_addr) {
+    cc__wake64(p_addr, 1);
+}
+
+
+/*
+    Parking lot: a global hashed table of wait queues keyed by address (after WebKit's ParkingLot).
+    Objects built on it keep only a few bits of state and no per-object kernel resource,
+    the queue nodes live on the stacks of the parked threads.
+*/
+typedef struct cc__park_node {
+    void *p_addr;
+    struct cc__park_node *p_next;
+    uint32_t unparked;  /* parked threads sleep on it */
+} cc__park_node;
+
+typedef struct {
+    CC__ALIGNED(CC_CACHE_LINE_SIZE) uint32_t lock;  /* 0: unlocked, 1: locked, 2: contended */
+    cc__park_node *p_head;
+    cc__park_node *p_tail;
+} cc__park_bucket;
+
+CC__SHARED cc__park_bucket cc__park_table[CC_PARK_TABLE_SIZE] = { { 0, NULL, NULL } };
+
+static inline cc__park_bucket *cc__park_bucket_lock(void *p_addr) {
+    uint64_t h = (uint64_t)(uintptr_t)p_addr * 0x9E3779B97F4A7C15ULL;
+    cc__park_bucket *p_bucket = &cc__park_table[(h >> 32) % CC_PARK_TABLE_SIZE];
+    uint32_t expected = 0;
+    int spin;
+
+    if (cc_atomic_cas_u32(&p_bucket->lock, &expected, 1, CC_MO_ACQUIRE, CC_MO_RELAXED)) return p_bucket;
+    for (spin = 0; spin < CC_MTX_SPIN_MAX; spin++) {
+        expected = 0;
+        if (cc_atomic_cas_u32(&p_bucket->lock, &expected, 1, CC_MO_ACQUIRE, CC_MO_RELAXED)) return p_bucket;
+        cc__cpu_relax();
+    }
+    while (0 != cc_atomic_exchange_u32(&p_bucket->lock, 2, CC_MO_ACQUIRE))
+        cc_wait(&p_bucket->lock, 2, NULL);
+    return p_bucket;
+}
+
+static inline void cc__park_bucket_unlock(cc__park_bucket *p_bucket) {
+    if (2 == cc_atomic_exchange_u32(&p_bucket->lock, 0, CC_MO_RELEASE))
+        cc_wake_one(&p_bucket->lock);
+}
+
+/* unlinks "p_node" from the bucket queue, returns 0 if it was already dequeued */
+static inline int cc__park_bucket_remove(cc__park_bucket *p_bucket, cc__park_node *p_node) {
+    cc__park_node *p_prev = NULL, *p_cur = p_bucket->p_head;
+    while (p_cur && p_cur != p_node) {
+        p_prev = p_cur;
+        p_cur = p_cur->p_next;
+    }
+    if (!p_cur) return 0;
+    if (p_prev) p_prev->p_next = p_cur->p_next;
+    else p_bucket->p_head = p_cur->p_next;
+    if (p_bucket->p_tail == p_cur) p_bucket->p_tail = p_prev;
+    return 1;
+}
+
+/*
+    Parks the calling thread on "p_addr" if "validate(arg)" (NULL: always) holds, checked under the bucket lock.
+    Returns 0 once unparked, EAGAIN if validation failed, ETIMEDOUT if "p_abstime" expired first.
+    NOTE: "validate" runs with the bucket locked, it must not park or unpark.
+*/
+static inline int cc_park(void *p_addr, int (*validate)(void *arg), void *arg, const struct timespec *p_abstime) {
+    cc__park_bucket *p_bucket = cc__park_bucket_lock(p_addr);
+    cc__park_node node;
+    int removed;
+
+    if (validate && !validate(arg)) {
+        cc__park_bucket_unlock(p_bucket);
+        return EAGAIN;
+    }
+    node.p_addr = p_addr;
+    node.p_next = NULL;
+    node.unparked = 0;
+    if (p_bucket->p_tail) p_bucket->p_tail->p_next = &node;
+    else p_bucket->p_head = &node;
+    p_bucket->p_tail = &node;
+    cc__park_bucket_unlock(p_bucket);
+
+    while (0 == cc_atomic_load_u32(&node.unparked, CC_MO_ACQUIRE)) {
+        if (ETIMEDOUT != cc_wait(&node.unparked, 0, p_abstime)) continue;
+        p_bucket = cc__park_bucket_lock(p_addr);
+        removed = cc__park_bucket_remove(p_bucket, &node);
+        cc__park_bucket_unlock(p_bucket);
+        if (removed) return ETIMEDOUT;
+        /* an unparker already dequeued us, wait for it to finish the handoff */
+        p_abstime = NULL;
+    }
+    return 0;
+}
+
+/*
+    Unparks the oldest thread parked on "p_addr", returns the number of threads woken (0 or 1).
+    "callback(arg, did_unpark, may_have_more)" (may be NULL) runs under the bucket lock, before the thread wakes up,
+    so objects can update their "parked" bit atomically with respect to new parkers.
+*/
+static inline int cc_unpark_one(void *p_addr, void (*callback)(void *arg, int did_unpark, int may_have_more), void *arg) {
+    cc__park_bucket *p_bucket = cc__park_bucket_lock(p_addr);
+    cc__park_node *p_node = p_bucket->p_head, *p_more;
+
+    while (p_node && p_node->p_addr != p_addr) p_node = p_node->p_next;
+    if (p_node) cc__park_bucket_remove(p_bucket, p_node);
+    for (p_more = p_node ? p_node->p_next : NULL; p_more && p_more->p_addr != p_addr; p_more = p_more->p_next) {}
+    if (callback) callback(arg, NULL != p_node, NULL != p_more);
+    if (p_node) cc_atomic_store_u32(&p_node->unparked, 1, CC_MO_RELEASE);
+    cc__park_bucket_unlock(p_bucket);
+
+    /* only the address is used from here on, the woken thread may already have returned */
+    if (p_node) cc_wake_one(&p_node->unparked);
+    return NULL != p_node;
+}
+
+/* unparks every thread parked on "p_addr", returns how many were woken */
+static inline int cc_unpark_all(void *p_addr) {
+    cc__park_bucket *p_bucket = cc__park_bucket_lock(p_addr);
+    cc__park_node *p_node = p_bucket->p_head, *p_next, *p_list = NULL;
+    int count = 0;
+
+    while (p_node) {
+        p_next = p_node->p_next;
+        if (p_node->p_addr == p_addr) {
+            cc__park_bucket_remove(p_bucket, p_node);
+            p_node->p_next = p_list;
+            p_list = p_node;
+        }
+        p_node = p_next;
+    }
+    cc__park_bucket_unlock(p_bucket);
+
+    for (p_node = p_list; p_node; p_node = p_next, count++) {
+        p_next = p_node->p_next;
+        cc_atomic_store_u32(&p_node->unparked, 1, CC_MO_RELEASE);
+        cc_wake_one(&p_node->unparked);
+    }
+    return count;
+}
+
+/* generic "validate" for byte objects: park only if the byte still holds the expected value */
+typedef struct {
+    uint8_t *p_byte;
+    uint8_t expected;
+} cc__park_byte;
+
+static inline int cc__park_validate_byte(void *arg) {
+    cc__park_byte *p_check = (cc__park_byte *)arg;
+    return cc_atomic_load_u8(p_check->p_byte, CC_MO_RELAXED) == p_check->expected;
+}
+
+
+
+static inline int cc_th_attr_destroy(cc_th_attr *p_attr) {
 #if defined(CC_POSIX)
-    return pthread_getspecific(key);
+    return pthread_attr_destroy(p_attr);
+#elif defined(CC_WINDOWS)  /* nop */
+    (void)p_attr;
+    return 0;
+#endif
+}
+
+static inline int cc_th_attr_getdetachstate(cc_th_attr *p_attr, int *p_detachstate) {
+#if defined(CC_POSIX)
+    return pthread_attr_getdetachstate(p_attr, p_detachstate);
 #elif defined(CC_WINDOWS)
-    return TlsGetValue(key);
+    if (!p_detachstate || !p_attr) return -1;
+    *(p_detachstate) = p_attr->detach_state;
+    return 0;
 #endif
 }
 
-/* NOTE: Use "cc_tls_cleanup" to deallocate memory per thread */
-static inline int cc_tls_key_create(cc_tls_key *p_key) {
+static inline int cc_th_attr_getguardsize(cc_th_attr *p_attr, size_t *p_guardsize) {
 #if defined(CC_POSIX)
-    if (!p_key) return -1;
-    return pthread_key_create(p_key, NULL);
+    return pthread_attr_getguardsize(p_attr, p_guardsize);
 #elif defined(CC_WINDOWS)
-    if (!p_key) return -1;
-    *p_key = TlsAlloc();
-    if (*p_key == TLS_OUT_OF_INDEXES) return -1;
+    if (!p_guardsize || !p_attr) return -1;
+    *(p_guardsize) = WINDOWS_DEFAULT_GUARD_SIZE;
     return 0;
 #endif
 }
 
-static inline int cc_tls_key_delete(cc_tls_key key) {
+static inline int cc_th_attr_getinheritsched(cc_th_attr *p_attr, int *p_inheritsched) {
 #if defined(CC_POSIX)
-    return pthread_key_delete(key);
+    return pthread_attr_getinheritsched(p_attr, p_inheritsched);
 #elif defined(CC_WINDOWS)
-    if (!TlsFree(key)) return -1;
+    if (!p_inheritsched || !p_attr) return -1;
+    *(p_inheritsched) = p_attr->inherit_sched;
     return 0;
 #endif
 }
 
-static inline cc_th_id cc_th_self(void) {
+static inline int cc_th_attr_getschedpolicy(cc_th_attr *p_attr, int *p_schedpolicy) {
 #if defined(CC_POSIX)
-    return pthread_self();
+    return pthread_attr_getschedpolicy(p_attr, p_schedpolicy);
 #elif defined(CC_WINDOWS)
-    return GetCurrentThreadId();
+    if (!p_schedpolicy || ! p_attr) return -1;
+    *(p_schedpolicy) = p_attr->sched_policy;
+    return 0;
 #endif
 }
 
-static inline int cc_tls_set(cc_tls_key key, void *value) {
+static inline int cc_th_attr_getscope(cc_th_attr *p_attr, int *p_contentionscope) {
 #if defined(CC_POSIX)
-    return pthread_setspecific(key, value);
+    return pthread_attr_getscope(p_attr, p_contentionscope);
 #elif defined(CC_WINDOWS)
-    if (!TlsSetValue(key, value)) return -1;
+    if (!p_contentionscope || !p_attr) return -1;
+    *(p_contentionscope) = p_attr->contention_scope;
     return 0;
 #endif
 }
 
-#define cc_tls_cleanup(key, free_func) \
-    do { \
-        void *val = cc_tls_get(key); \
-        if (val) { \
-            free_func(val); \
-            cc_tls_set(key, NULL); \
-        } \
-    } while(0)
+static inline int cc_th_attr_getstacksize(cc_th_attr *p_attr, size_t *p_stacksize) {
+#if defined(CC_POSIX)
+    return pthread_attr_getstacksize(p_attr, p_stacksize);
+#elif defined(CC_WINDOWS)
+    if (!p_stacksize || !p_attr) return -1;
+    *(p_stacksize) = p_attr->stack_size;
+    return 0;
+#endif
+}
+
+static inline int cc_th_attr_init(cc_th_attr *p_attr) {
+#if defined(CC_POSIX)
+    return pthread_attr_init(p_attr);
+#elif defined(CC_WINDOWS)
+    if (!p_attr) return -1;
+    p_attr->detach_state = CC_TH_JOINABLE;
+    p_attr->stack_size = 0;
+    p_attr->inherit_sched = CC_EXPLICIT_SCHED;  /* default explicit scheduling */
+    p_attr->contention_scope = CC_SCOPE_SYSTEM;  /* default to system scope for Windows */ 
+    return 0;
+#endif
+}
+
+static inline int cc_th_attr_setdetachstate(cc_th_attr *p_attr, int detachstate) {
+#if defined(CC_POSIX)
+    return pthread_attr_setdetachstate(p_attr, detachstate);
+#elif defined(CC_WINDOWS)
+    if (!p_attr) return -1;
+    p_attr->detach_state = detachstate;
+    return 0;
+#endif
+}
+
+static inline int cc_th_attr_setguardsize(cc_th_attr *p_attr, size_t guardsize) {
+#if defined(CC_POSIX)
+    return pthread_attr_setguardsize(p_attr, guardsize);
+#elif defined(CC_WINDOWS)  /* nop */
+    (void)p_attr;
+    (void)guardsize;
+    return 0;
+#endif
+}
+
+static inline int cc_th_attr_setinheritsched(cc_th_attr *p_attr, int inheritsched) {
+#if defined(CC_POSIX)
+    return pthread_attr_setinheritsched(p_attr, inheritsched);
+#elif defined(CC_WINDOWS)
+    if (!p_attr) return -1;
+    p_attr->inherit_sched = inheritsched;
+    return 0;
+#endif
+}
+
+static inline int cc_th_attr_setschedpolicy(cc_th_attr *p_attr, int schedpolicy) {
+#if defined(CC_POSIX)
+    return pthread_attr_setschedpolicy(p_attr, schedpolicy);
+#elif defined(CC_WINDOWS)
+    if (!p_attr) return -1;
+    p_attr->sched_policy = schedpolicy;
+    return 0;
+#endif
+}
 
+static inline int cc_th_attr_setscope(cc_th_attr *p_attr, int contentionscope) {
+#if defined(CC_POSIX)
+    return pthread_attr_setscope(p_attr, contentionscope);
+#elif defined(CC_WINDOWS)
+    if (!p_attr) return -1;
+    p_attr->contention_scope = contentionscope;
+    return 0;
+#endif
+}
+
+static inline int cc_th_attr_setstacksize(cc_th_attr *p_attr, size_t stacksize) {
+#if defined(CC_POSIX)
+    return pthread_attr_setstacksize(p_attr, stacksize);
+#elif defined(CC_WINDOWS)
+    if (!p_attr) return -1;
+    p_attr->stack_size = stacksize;
+    return 0;
+#endif
+}
+
+static inline int cc_th_create(cc_th *p_th, cc_th_attr *p_attr, void *(*th_func)(void *), void *arg) {
+#if defined(CC_POSIX)
+    return pthread_create(p_th, p_attr, th_func, arg);
+#elif defined(CC_WINDOWS)
+    SIZE_T actual_stacksize = 0;
+    int initial_thread_priority = THREAD_PRIORITY_NORMAL;
+
+    if (p_attr) {
+        if (p_attr->stack_size > 0) actual_stacksize = (SIZE_T)p_attr->stack_size;
+        if (p_attr->inherit_sched == CC_INHERIT_SCHED) {
+            initial_thread_priority = GetThreadPriority(GetCurrentThread());
+            if (initial_thread_priority == THREAD_PRIORITY_ERROR_RETURN)
+                initial_thread_priority = THREAD_PRIORITY_NORMAL;
+        }
+    }
+
+    *p_th = CreateThread(
+        NULL,
+        actual_stacksize,
+        (LPTHREAD_START_ROUTINE)th_func,
+        (LPVOID)arg,
+        CREATE_SUSPENDED,
+        NULL
+    );
+    if (!*p_th) return -1;
+
+    if (initial_thread_priority != THREAD_PRIORITY_NORMAL)
+        SetThreadPriority(*p_th, initial_thread_priority);
+    
+    /* resume thread after setting properties */
+    ResumeThread(*p_th);
+
+    if (p_attr && CC_TH_DETACHED == p_attr->detach_state) {
+        if (!CloseHandle(*p_th)) return -2;
+        *p_th = NULL;
+    }
+    return 0;
+#endif
+}
+
+static inline int cc_th_detach(cc_th *p_th) {
+#if defined(CC_POSIX)
+    if (!p_th) return -1;
+    return pthread_detach(*p_th);
+#elif defined(CC_WINDOWS)
+    if (!p_th) return -1;
+    if (!*p_th) return 0;
+    if (!CloseHandle(*p_th)) return -2;
+    *p_th = NULL;
+    return 0;
+#endif
+}
+
+static inline int cc_th_equal_id(cc_th_id id1, cc_th_id id2) {
+#if defined(CC_POSIX)
+    return pthread_equal(id1, id2);
+#elif defined(CC_WINDOWS)
+    return (id1 == id2);
+#endif
+}
+
+static inline void cc_th_exit(void *retval) {
+#if defined(CC_POSIX)
+    pthread_exit(retval);
+#elif defined(CC_WINDOWS)
+    /* NOTE: retval should be a small integer status code. Code doesn't work for words larger than DWORD_MAX */
+    ExitThread((DWORD)(ULONG_PTR)retval);
+#endif
+}
+
+static inline int cc_th_join(cc_th th, void **retval) {
+#if defined(CC_POSIX)
+    return pthread_join(th, retval);
+#elif defined(CC_WINDOWS)
+    DWORD exit_code;
+    DWORD wait_result = WaitForSingleObject(th, INFINITE);
+
+    if (WAIT_OBJECT_0 == wait_result) {
+        if (GetExitCodeThread(th, &exit_code)) {
+            if (retval != NULL) *retval = (void*)(ULONG_PTR)exit_code;
+            if (!CloseHandle(th)) return -2;
+            return 0;
+        }
+        else return -1;
+    }
+    else if (WAIT_ABANDONED == wait_result) return -3;
+    else if (WAIT_TIMEOUT == wait_result) return -4;
+    else return -5;
+#endif    
+}
+
+static inline void *cc_tls_get(cc_tls_key key) {
+#if defined(CC_POSIX)
+    return pthread_getspecific(key);
+#elif defined(CC_WINDOWS)
+    return TlsGetValue(key);
+#endif
+}
+
+/* NOTE: Use "cc_tls_cleanup" to deallocate memory per thread, use "cc_call_once" to create shared keys lazily */
+static inline int cc_tls_key_create(cc_tls_key *p_key) {
+#if defined(CC_POSIX)
+    if (!p_key) return -1;
+    return pthread_key_create(p_key, NULL);
+#elif defined(CC_WINDOWS)
+    if (!p_key) return -1;
+    *p_key = TlsAlloc();
+    if (*p_key == TLS_OUT_OF_INDEXES) return -1;
+    return 0;
+#endif
+}
+
+static inline int cc_tls_key_delete(cc_tls_key key) {
+#if defined(CC_POSIX)
+    return pthread_key_delete(key);
+#elif defined(CC_WINDOWS)
+    if (!TlsFree(key)) return -1;
+    return 0;
+#endif
+}
+
+static CC__NOINLINE int cc__call_once_slow(cc_once *p_once, void (*init_func)(void)) {
+    uint8_t state = cc_atomic_load_u8(&p_once->state, CC_MO_ACQUIRE);
+    cc__park_byte check;
+
+    check.p_byte = &p_once->state;
+    check.expected = 2;
+    for (;;) {
+        if (3 == state) return 0;
+        if (0 == state) {
+            if (cc_atomic_cas_u8(&p_once->state, &state, 1, CC_MO_ACQUIRE, CC_MO_ACQUIRE)) {
+                init_func();
+                if (2 == cc_atomic_exchange_u8(&p_once->state, 3, CC_MO_RELEASE))
+                    cc_unpark_all(&p_once->state);
+                return 0;
+            }
+            continue;
+        }
+        if (1 == state && !cc_atomic_cas_u8(&p_once->state, &state, 2, CC_MO_ACQUIRE, CC_MO_ACQUIRE)) continue;
+        cc_park(&p_once->state, cc__park_validate_byte, &check, NULL);
+        state = cc_atomic_load_u8(&p_once->state, CC_MO_ACQUIRE);
+    }
+}
+
+/* NOTE: once "init_func" has run, this is a single acquire load (the slow path is kept out of line) */
+static inline int cc_call_once(cc_once *p_once, void (*init_func)(void)) {
+    if (CC__LIKELY(3 == cc_atomic_load_u8(&p_once->state, CC_MO_ACQUIRE))) return 0;
+    return cc__call_once_slow(p_once, init_func);
+}
+
+static inline cc_th_id cc_th_self(void) {
+#if defined(CC_POSIX)
+    return pthread_self();
+#elif defined(CC_WINDOWS)
+    return GetCurrentThreadId();
+#endif
+}
+
+static inline int cc_tls_set(cc_tls_key key, void *value) {
+#if defined(CC_POSIX)
+    return pthread_setspecific(key, value);
+#elif defined(CC_WINDOWS)
+    if (!TlsSetValue(key, value)) return -1;
+    return 0;
+#endif
+}
+
+#define cc_tls_cleanup(key, free_func) \
+    do { \
+        void *val = cc_tls_get(key); \
+        if (val) { \
+            free_func(val); \
+            cc_tls_set(key, NULL); \
+        } \
+    } while(0)
+
+static inline int cc_mtx_init(cc_mtx *p_mtx) {
+    if (!p_mtx) return -1;
+    p_mtx->state = 0;
+    p_mtx->spin = 0;
+    return 0;
+}
+
+static inline int cc_mtx_destroy(cc_mtx *p_mtx) {
+    if (!p_mtx) return -1;
+    if (0 != cc_atomic_load_u32(&p_mtx->state, CC_MO_RELAXED)) return EBUSY;
+    return 0;
+}
+
+/*
+    Contended path: spins for an adaptive number of iterations (glibc's PTHREAD_MUTEX_ADAPTIVE_NP heuristic),
+    then marks the lock as contended and parks on the futex until the owner releases it.
+*/
+static CC__NOINLINE int cc__mtx_lock_slow(cc_mtx *p_mtx, const struct timespec *p_abstime) {
+    uint32_t spin = cc_atomic_load_u32(&p_mtx->spin, CC_MO_RELAXED);
+    uint32_t max_spin = spin * 2 + 10;
+    uint32_t expected;
+    uint32_t cnt;
+
+    if (max_spin > CC_MTX_SPIN_MAX) max_spin = CC_MTX_SPIN_MAX;
+    for (cnt = 0; cnt < max_spin; cnt++) {
+        expected = 0;
+        if (0 == cc_atomic_load_u32(&p_mtx->state, CC_MO_RELAXED)
+            && cc_atomic_cas_u32(&p_mtx->state, &expected, 1, CC_MO_ACQUIRE, CC_MO_RELAXED)) break;
+        cc__cpu_relax();
+    }
+    cc_atomic_store_u32(&p_mtx->spin, (uint32_t)((int32_t)spin + ((int32_t)cnt - (int32_t)spin) / 8), CC_MO_RELAXED);
+    if (cnt < max_spin) return 0;
+
+    while (0 != cc_atomic_exchange_u32(&p_mtx->state, 2, CC_MO_ACQUIRE)) {
+        if (ETIMEDOUT == cc_wait(&p_mtx->state, 2, p_abstime)) return ETIMEDOUT;
+    }
+    return 0;
+}
+
+static inline int cc_mtx_lock(cc_mtx *p_mtx) {
+    uint32_t expected = 0;
+    if (cc_atomic_cas_u32(&p_mtx->state, &expected, 1, CC_MO_ACQUIRE, CC_MO_RELAXED)) return 0;
+    return cc__mtx_lock_slow(p_mtx, NULL);
+}
+
+/* NOTE: "p_abstime" is an absolute CLOCK_MONOTONIC deadline (see "cc_time_monotonic" and "cc_time_add_ms") */
+static inline int cc_mtx_timedlock(cc_mtx *p_mtx, const struct timespec *p_abstime) {
+    uint32_t expected = 0;
+    if (!p_abstime) return -1;
+    if (cc_atomic_cas_u32(&p_mtx->state, &expected, 1, CC_MO_ACQUIRE, CC_MO_RELAXED)) return 0;
+    return cc__mtx_lock_slow(p_mtx, p_abstime);
+}
+
+static inline int cc_mtx_trylock(cc_mtx *p_mtx) {
+    uint32_t expected = 0;
+    if (cc_atomic_cas_u32(&p_mtx->state, &expected, 1, CC_MO_ACQUIRE, CC_MO_RELAXED)) return 0;
+    return EBUSY;
+}
+
+static inline int cc_mtx_unlock(cc_mtx *p_mtx) {
+    if (2 == cc_atomic_exchange_u32(&p_mtx->state, 0, CC_MO_RELEASE))
+        cc_wake_one(&p_mtx->state);
+    return 0;
+}
+
+
+/*
+    Relocks a mutex on behalf of a thread woken from a "cc_cond": the lock is always marked contended,
+    because other waiters may have been requeued onto it and only a contended unlock wakes them.
+*/
+static inline void cc__mtx_lock_contended(cc_mtx *p_mtx) {
+    while (0 != cc_atomic_exchange_u32(&p_mtx->state, 2, CC_MO_ACQUIRE))
+        cc_wait(&p_mtx->state, 2, NULL);
+}
+
+static inline int cc_cond_init(cc_cond *p_cond) {
+    if (!p_cond) return -1;
+    p_cond->seq = 0;
+    p_cond->waiters = 0;
+    p_cond->p_mtx = NULL;
+    return 0;
+}
+
+static inline int cc_cond_destroy(cc_cond *p_cond) {
+    if (!p_cond) return -1;
+    if (0 != cc_atomic_load_u32(&p_cond->waiters, CC_MO_RELAXED)) return EBUSY;
+    return 0;
+}
+
+/* NOTE: "p_abstime" is an absolute CLOCK_MONOTONIC deadline, the mutex is reacquired even on timeout */
+static inline int cc_cond_timedwait(cc_cond *p_cond, cc_mtx *p_mtx, const struct timespec *p_abstime) {
+    uint32_t seq = cc_atomic_load_u32(&p_cond->seq, CC_MO_RELAXED);
+    int ret;
+
+    cc_atomic_fetch_add_u32(&p_cond->waiters, 1, CC_MO_RELAXED);
+    if (cc_atomic_load_ptr(&p_cond->p_mtx, CC_MO_RELAXED) != (void *)p_mtx)
+        cc_atomic_store_ptr(&p_cond->p_mtx, (void *)p_mtx, CC_MO_RELAXED);
+    cc_mtx_unlock(p_mtx);
+
+    ret = cc_wait(&p_cond->seq, seq, p_abstime);
+    /* a broadcast may have requeued us onto the mutex futex, where the deadline kept running: still signalled */
+    if (ETIMEDOUT == ret && cc_atomic_load_u32(&p_cond->seq, CC_MO_RELAXED) != seq) ret = 0;
+
+    cc_atomic_fetch_sub_u32(&p_cond->waiters, 1, CC_MO_RELAXED);
+    cc__mtx_lock_contended(p_mtx);
+    return ret;
+}
+
+static inline int cc_cond_wait(cc_cond *p_cond, cc_mtx *p_mtx) {
+    return cc_cond_timedwait(p_cond, p_mtx, NULL);
+}
+
+static inline int cc_cond_signal(cc_cond *p_cond) {
+    if (0 == cc_atomic_load_u32(&p_cond->waiters, CC_MO_RELAXED)) return 0;
+    cc_atomic_fetch_add_u32(&p_cond->seq, 1, CC_MO_RELEASE);
+    cc_wake_one(&p_cond->seq);
+    return 0;
+}
+
+/*
+    On Linux only one waiter is woken, the others are moved (FUTEX_CMP_REQUEUE) onto the mutex futex and
+    wake up one at a time as the mutex is released, instead of all stampeding on it at once.
+    NOTE: elsewhere all waiters are woken.
+*/
+static inline int cc_cond_broadcast(cc_cond *p_cond) {
+    uint32_t seq;
+#if defined(CC_POSIX) && defined(__linux__)
+    cc_mtx *p_mtx;
+#endif
+
+    if (0 == cc_atomic_load_u32(&p_cond->waiters, CC_MO_RELAXED)) return 0;
+    seq = cc_atomic_fetch_add_u32(&p_cond->seq, 1, CC_MO_RELEASE) + 1;
+#if defined(CC_POSIX) && defined(__linux__)
+    p_mtx = (cc_mtx *)cc_atomic_load_ptr(&p_cond->p_mtx, CC_MO_RELAXED);
+    if (p_mtx && syscall(SYS_futex, &p_cond->seq, FUTEX_CMP_REQUEUE_PRIVATE, 1, (long)INT_MAX, &p_mtx->state, seq) >= 0)
+        return 0;
+#else
+    (void)seq;
+#endif
+    cc_wake_all(&p_cond->seq);
+    return 0;
+}
+
+static inline int cc_sem_init(cc_sem *p_sem, uint32_t value) {
+    if (!p_sem) return -1;
+    p_sem->count = value;
+    p_sem->waiters = 0;
+    p_sem->big_waiters = 0;
+    return 0;
+}
+
+static inline int cc_sem_destroy(cc_sem *p_sem) {
+    if (!p_sem) return -1;
+    if (0 != cc_atomic_load_u32(&p_sem->waiters, CC_MO_RELAXED)) return EBUSY;
+    return 0;
+}
+
+static inline int cc_sem_getvalue(cc_sem *p_sem, uint32_t *p_value) {
+    if (!p_sem || !p_value) return -1;
+    *p_value = cc_atomic_load_u32(&p_sem->count, CC_MO_RELAXED);
+    return 0;
+}
+
+/* takes "n" permits if available, never blocks */
+static inline int cc__sem_take(cc_sem *p_sem, uint32_t n) {
+    uint32_t c = cc_atomic_load_u32(&p_sem->count, CC_MO_RELAXED);
+    while (c >= n) {
+        if (cc_atomic_cas_u32(&p_sem->count, &c, c - n, CC_MO_ACQUIRE, CC_MO_RELAXED)) return 1;
+    }
+    return 0;
+}
+
+static CC__NOINLINE int cc__sem_wait_slow(cc_sem *p_sem, uint32_t n, const struct timespec *p_abstime) {
+    uint32_t c;
+    int spin, ret = 0;
+
+    for (spin = 0; spin < CC_MTX_SPIN_MAX; spin++) {
+        if (cc__sem_take(p_sem, n)) return 0;
+        cc__cpu_relax();
+    }
+
+    cc_atomic_fetch_add_u32(&p_sem->waiters, 1, CC_MO_SEQ_CST);
+    if (n > 1) cc_atomic_fetch_add_u32(&p_sem->big_waiters, 1, CC_MO_SEQ_CST);
+    for (;;) {
+        c = cc_atomic_load_u32(&p_sem->count, CC_MO_SEQ_CST);
+        if (c >= n) {
+            if (cc_atomic_cas_u32(&p_sem->count, &c, c - n, CC_MO_ACQUIRE, CC_MO_RELAXED)) break;
+            continue;
+        }
+        if (ETIMEDOUT == cc_wait(&p_sem->count, c, p_abstime)) {
+            ret = ETIMEDOUT;
+            break;
+        }
+    }
+    if (n > 1) cc_atomic_fetch_sub_u32(&p_sem->big_waiters, 1, CC_MO_RELAXED);
+    cc_atomic_fetch_sub_u32(&p_sem->waiters, 1, CC_MO_RELAXED);
+    return ret;
+}
+
+/* NOTE: "p_abstime" is an absolute CLOCK_MONOTONIC deadline */
+static inline int cc_sem_timedwait_n(cc_sem *p_sem, uint32_t n, const struct timespec *p_abstime) {
+    if (cc__sem_take(p_sem, n)) return 0;
+    return cc__sem_wait_slow(p_sem, n, p_abstime);
+}
+
+static inline int cc_sem_timedwait(cc_sem *p_sem, const struct timespec *p_abstime) {
+    return cc_sem_timedwait_n(p_sem, 1, p_abstime);
+}
+
+static inline int cc_sem_wait_n(cc_sem *p_sem, uint32_t n) {
+    return cc_sem_timedwait_n(p_sem, n, NULL);
+}
+
+static inline int cc_sem_wait(cc_sem *p_sem) {
+    return cc_sem_timedwait_n(p_sem, 1, NULL);
+}
+
+static inline int cc_sem_trywait_n(cc_sem *p_sem, uint32_t n) {
+    return cc__sem_take(p_sem, n) ? 0 : EAGAIN;
+}
+
+static inline int cc_sem_trywait(cc_sem *p_sem) {
+    return cc__sem_take(p_sem, 1) ? 0 : EAGAIN;
+}
+
+/*
+    Releases "n" permits with at most one wake syscall. Single-permit waiters are woken "n" at a time,
+    if some thread waits for several permits every waiter is woken to re-check the count.
+*/
+static inline int cc_sem_post_n(cc_sem *p_sem, uint32_t n) {
+    cc_atomic_fetch_add_u32(&p_sem->count, n, CC_MO_SEQ_CST);
+    if (0 == cc_atomic_load_u32(&p_sem->waiters, CC_MO_SEQ_CST)) return 0;
+    if (0 != cc_atomic_load_u32(&p_sem->big_waiters, CC_MO_RELAXED) || n > INT_MAX)
+        cc_wake_all(&p_sem->count);
+    else cc__wake_n(&p_sem->count, (int)n);
+    return 0;
+}
+
+static inline int cc_sem_post(cc_sem *p_sem) {
+    return cc_sem_post_n(p_sem, 1);
+}
+
+static inline int cc_barrier_init(cc_barrier *p_bar, uint32_t count, int algorithm) {
+    if (!p_bar || 0 == count) return -1;
+    if (CC_BARRIER_AUTO == algorithm)
+        algorithm = (count <= CC_BARRIER_CENTRAL_MAX) ? CC_BARRIER_CENTRAL : CC_BARRIER_DISSEMINATION;
+
+    p_bar->algorithm = algorithm;
+    p_bar->count = count;
+    p_bar->rounds = 0;
+    p_bar->arrived = 0;
+    p_bar->episode = 0;
+    p_bar->sleepers = 0;
+    p_bar->p_nodes = NULL;
+
+    if (CC_BARRIER_DISSEMINATION == algorithm) {
+        while (p_bar->rounds < 32 && (1ULL << p_bar->rounds) < count) p_bar->rounds++;
+        p_bar->p_nodes = (cc__barrier_node *)calloc(count, sizeof(cc__barrier_node));
+        if (!p_bar->p_nodes) return -2;
+    }
+    else if (CC_BARRIER_CENTRAL != algorithm) return -1;
+    return 0;
+}
+
+static inline int cc_barrier_destroy(cc_barrier *p_bar) {
+    if (!p_bar) return -1;
+    free(p_bar->p_nodes);
+    p_bar->p_nodes = NULL;
+    return 0;
+}
+
+/* sense-reversing barrier, the episode counter plays the role of the sense flag */
+static inline int cc__barrier_wait_central(cc_barrier *p_bar) {
+    uint32_t ep = cc_atomic_load_u32(&p_bar->episode, CC_MO_ACQUIRE);
+    int spin;
+
+    if (cc_atomic_fetch_add_u32(&p_bar->arrived, 1, CC_MO_ACQ_REL) + 1 == p_bar->count) {
+        cc_atomic_store_u32(&p_bar->arrived, 0, CC_MO_RELAXED);
+        cc_atomic_fetch_add_u32(&p_bar->episode, 1, CC_MO_SEQ_CST);
+        if (0 != cc_atomic_load_u32(&p_bar->sleepers, CC_MO_SEQ_CST))
+            cc_wake_all(&p_bar->episode);
+        return CC_BARRIER_SERIAL_THREAD;
+    }
+
+    for (spin = 0; spin < CC_MTX_SPIN_MAX; spin++) {
+        if (ep != cc_atomic_load_u32(&p_bar->episode, CC_MO_ACQUIRE)) return 0;
+        cc__cpu_relax();
+    }
+    cc_atomic_fetch_add_u32(&p_bar->sleepers, 1, CC_MO_SEQ_CST);
+    while (ep == cc_atomic_load_u32(&p_bar->episode, CC_MO_SEQ_CST))
+        cc_wait(&p_bar->episode, ep, NULL);
+    cc_atomic_fetch_sub_u32(&p_bar->sleepers, 1, CC_MO_RELAXED);
+    return 0;
+}
+
+#define CC__BARRIER_SLEEPING    0x80000000U
+#define CC__BARRIER_EPISODE     0x7FFFFFFFU
+
+/*
+    Dissemination barrier: in round "r" participant "id" notifies "id + 2^r" and waits for "id - 2^r",
+    so every thread only touches its own flags and one partner's, in ceil(log2(count)) rounds.
+    Flags hold the episode number (31 bits), the top bit marks a participant parked on the flag.
+*/
+static inline int cc__barrier_wait_dissemination(cc_barrier *p_bar, uint32_t id) {
+    cc__barrier_node *p_self = &p_bar->p_nodes[id];
+    uint32_t ep = (p_self->episode + 1) & CC__BARRIER_EPISODE;
+    uint32_t *p_partner_flag, *p_flag;
+    uint32_t r, flag;
+    int spin;
+
+    p_self->episode = ep;
+    for (r = 0; r < p_bar->rounds; r++) {
+        p_partner_flag = &p_bar->p_nodes[(uint32_t)(((uint64_t)id + (1ULL << r)) % p_bar->count)].flags[r];
+        if (CC__BARRIER_SLEEPING & cc_atomic_exchange_u32(p_partner_flag, ep, CC_MO_RELEASE))
+            cc_wake_one(p_partner_flag);
+
+        p_flag = &p_self->flags[r];
+        spin = 0;
+        for (;;) {
+            flag = cc_atomic_load_u32(p_flag, CC_MO_ACQUIRE);
+            /* a partner may already be one episode ahead */
+            if (((flag - ep) & CC__BARRIER_EPISODE) < (CC__BARRIER_EPISODE >> 1)) break;
+            if (spin++ < CC_MTX_SPIN_MAX) cc__cpu_relax();
+            else if ((flag & CC__BARRIER_SLEEPING)
+                     || cc_atomic_cas_u32(p_flag, &flag, flag | CC__BARRIER_SLEEPING, CC_MO_RELAXED, CC_MO_RELAXED))
+                cc_wait(p_flag, flag | CC__BARRIER_SLEEPING, NULL);
+        }
+    }
+    return (0 == id) ? CC_BARRIER_SERIAL_THREAD : 0;
+}
+
+/*
+    Returns CC_BARRIER_SERIAL_THREAD for exactly one participant per episode, 0 for the others.
+    NOTE: "id" is the participant index in [0, count), every participant must use a distinct one.
+    It is only needed by the dissemination algorithm, the central barrier ignores it.
+*/
+static inline int cc_barrier_wait(cc_barrier *p_bar, uint32_t id) {
+    if (CC_BARRIER_CENTRAL == p_bar->algorithm) return cc__barrier_wait_central(p_bar);
+    if (id >= p_bar->count) return -1;
+    return cc__barrier_wait_dissemination(p_bar, id);
+}
+
+/* NOTE: a "cc_rwlock" is CC_RWLOCK_SLOTS cache lines wide, readers never write outside their own slot */
+static inline int cc_rwlock_init(cc_rwlock *p_rw) {
+    int i;
+    if (!p_rw) return -1;
+    for (i = 0; i < CC_RWLOCK_SLOTS; i++) p_rw->slots[i].readers = 0;
+    p_rw->writer = 0;
+    return cc_mtx_init(&p_rw->wr_mtx);
+}
+
+static inline int cc_rwlock_destroy(cc_rwlock *p_rw) {
+    if (!p_rw) return -1;
+    if (0 != cc_atomic_load_u32(&p_rw->writer, CC_MO_RELAXED)) return EBUSY;
+    return cc_mtx_destroy(&p_rw->wr_mtx);
+}
+
+/* the reader slot of the calling thread, "rdlock" and "rdunlock" must be called from the same thread */
+static inline cc__rw_slot *cc__rwlock_slot(cc_rwlock *p_rw) {
+    uint64_t h = (uint64_t)(uintptr_t)cc_th_self() * 0x9E3779B97F4A7C15ULL;
+    return &p_rw->slots[(h ^ (h >> 32)) % CC_RWLOCK_SLOTS];
+}
+
+static inline void cc__rwlock_wait_writer(cc_rwlock *p_rw) {
+    uint32_t w;
+    int spin;
+
+    for (spin = 0; spin < CC_MTX_SPIN_MAX; spin++) {
+        if (0 == cc_atomic_load_u32(&p_rw->writer, CC_MO_ACQUIRE)) return;
+        cc__cpu_relax();
+    }
+    w = cc_atomic_load_u32(&p_rw->writer, CC_MO_ACQUIRE);
+    while (0 != w) {
+        if (2 == w || cc_atomic_cas_u32(&p_rw->writer, &w, 2, CC_MO_ACQUIRE, CC_MO_ACQUIRE))
+            cc_wait(&p_rw->writer, 2, NULL);
+        w = cc_atomic_load_u32(&p_rw->writer, CC_MO_ACQUIRE);
+    }
+}
+
+/* drops a reader indicator, waking a draining writer once the slot is empty */
+static inline void cc__rwlock_slot_release(cc_rwlock *p_rw, cc__rw_slot *p_slot) {
+    if (1 == cc_atomic_fetch_sub_u32(&p_slot->readers, 1, CC_MO_SEQ_CST) && 0 != cc_atomic_load_u32(&p_rw->writer, CC_MO_SEQ_CST))
+        cc_wake_one(&p_slot->readers);
+}
+
+static inline int cc_rwlock_rdlock(cc_rwlock *p_rw) {
+    cc__rw_slot *p_slot = cc__rwlock_slot(p_rw);
+    for (;;) {
+        cc_atomic_fetch_add_u32(&p_slot->readers, 1, CC_MO_SEQ_CST);
+        if (0 == cc_atomic_load_u32(&p_rw->writer, CC_MO_SEQ_CST)) return 0;
+        cc__rwlock_slot_release(p_rw, p_slot);
+        cc__rwlock_wait_writer(p_rw);
+    }
+}
+
+static inline int cc_rwlock_tryrdlock(cc_rwlock *p_rw) {
+    cc__rw_slot *p_slot = cc__rwlock_slot(p_rw);
+    cc_atomic_fetch_add_u32(&p_slot->readers, 1, CC_MO_SEQ_CST);
+    if (0 == cc_atomic_load_u32(&p_rw->writer, CC_MO_SEQ_CST)) return 0;
+    cc__rwlock_slot_release(p_rw, p_slot);
+    return EBUSY;
+}
+
+static inline int cc_rwlock_rdunlock(cc_rwlock *p_rw) {
+    cc__rwlock_slot_release(p_rw, cc__rwlock_slot(p_rw));
+    return 0;
+}
+
+static inline void cc__rwlock_writer_leave(cc_rwlock *p_rw) {
+    if (2 == cc_atomic_exchange_u32(&p_rw->writer, 0, CC_MO_RELEASE))
+        cc_wake_all(&p_rw->writer);
+    cc_mtx_unlock(&p_rw->wr_mtx);
+}
+
+/* NOTE: the writer announces itself first, then drains every reader slot (new readers back off meanwhile) */
+static inline int cc_rwlock_wrlock(cc_rwlock *p_rw) {
+    uint32_t readers;
+    int i, spin;
+
+    cc_mtx_lock(&p_rw->wr_mtx);
+    cc_atomic_store_u32(&p_rw->writer, 1, CC_MO_SEQ_CST);
+    for (i = 0; i < CC_RWLOCK_SLOTS; i++) {
+        spin = 0;
+        while (0 != (readers = cc_atomic_load_u32(&p_rw->slots[i].readers, CC_MO_SEQ_CST))) {
+            if (spin++ < CC_MTX_SPIN_MAX) cc__cpu_relax();
+            else cc_wait(&p_rw->slots[i].readers, readers, NULL);
+        }
+    }
+    return 0;
+}
+
+static inline int cc_rwlock_trywrlock(cc_rwlock *p_rw) {
+    int i;
+
+    if (0 != cc_mtx_trylock(&p_rw->wr_mtx)) return EBUSY;
+    cc_atomic_store_u32(&p_rw->writer, 1, CC_MO_SEQ_CST);
+    for (i = 0; i < CC_RWLOCK_SLOTS; i++) {
+        if (0 != cc_atomic_load_u32(&p_rw->slots[i].readers, CC_MO_SEQ_CST)) {
+            cc__rwlock_writer_leave(p_rw);
+            return EBUSY;
+        }
+    }
+    return 0;
+}
+
+static inline int cc_rwlock_wrunlock(cc_rwlock *p_rw) {
+    cc__rwlock_writer_leave(p_rw);
+    return 0;
+}
+
+#define CC__BYTE_LOCKED     1
+#define CC__BYTE_SET        1
+#define CC__BYTE_PARKED     2
+
+static inline int cc_lock_init(cc_lock *p_lock) {
+    if (!p_lock) return -1;
+    p_lock->state = 0;
+    return 0;
+}
+
+static CC__NOINLINE void cc__lock_acquire_slow(cc_lock *p_lock) {
+    uint8_t state, expected;
+    cc__park_byte check;
+    int spin = 0;
+
+    check.p_byte = &p_lock->state;
+    check.expected = CC__BYTE_LOCKED | CC__BYTE_PARKED;
+    for (;;) {
+        state = cc_atomic_load_u8(&p_lock->state, CC_MO_RELAXED);
+        if (!(state & CC__BYTE_LOCKED)) {
+            if (cc_atomic_cas_u8(&p_lock->state, &state, (uint8_t)(state | CC__BYTE_LOCKED), CC_MO_ACQUIRE, CC_MO_RELAXED)) return;
+            continue;
+        }
+        if (!(state & CC__BYTE_PARKED) && spin++ < CC_MTX_SPIN_MAX) {
+            cc__cpu_relax();
+            continue;
+        }
+        expected = state;
+        if (!(state & CC__BYTE_PARKED)
+            && !cc_atomic_cas_u8(&p_lock->state, &expected, (uint8_t)(state | CC__BYTE_PARKED), CC_MO_RELAXED, CC_MO_RELAXED)) continue;
+        cc_park(&p_lock->state, cc__park_validate_byte, &check, NULL);
+    }
+}
+
+static inline int cc_lock_acquire(cc_lock *p_lock) {
+    uint8_t expected = 0;
+    if (!cc_atomic_cas_u8(&p_lock->state, &expected, CC__BYTE_LOCKED, CC_MO_ACQUIRE, CC_MO_RELAXED))
+        cc__lock_acquire_slow(p_lock);
+    return 0;
+}
+
+static inline int cc_lock_tryacquire(cc_lock *p_lock) {
+    uint8_t state = cc_atomic_load_u8(&p_lock->state, CC_MO_RELAXED);
+    while (!(state & CC__BYTE_LOCKED)) {
+        if (cc_atomic_cas_u8(&p_lock->state, &state, (uint8_t)(state | CC__BYTE_LOCKED), CC_MO_ACQUIRE, CC_MO_RELAXED)) return 0;
+    }
+    return EBUSY;
+}
+
+/* runs under the bucket lock: release the lock, keep the parked bit if other threads are still queued */
+static inline void cc__lock_unpark_callback(void *arg, int did_unpark, int may_have_more) {
+    (void)did_unpark;
+    cc_atomic_exchange_u8((uint8_t *)arg, may_have_more ? CC__BYTE_PARKED : 0, CC_MO_RELEASE);
+}
+
+static inline int cc_lock_release(cc_lock *p_lock) {
+    uint8_t expected = CC__BYTE_LOCKED;
+    if (!cc_atomic_cas_u8(&p_lock->state, &expected, 0, CC_MO_RELEASE, CC_MO_RELAXED))
+        cc_unpark_one(&p_lock->state, cc__lock_unpark_callback, &p_lock->state);
+    return 0;
+}
+
+static inline int cc_event_init(cc_event *p_event, int set) {
+    if (!p_event) return -1;
+    p_event->state = set ? CC__BYTE_SET : 0;
+    return 0;
+}
+
+static inline int cc_event_is_set(cc_event *p_event) {
+    return (cc_atomic_load_u8(&p_event->state, CC_MO_ACQUIRE) & CC__BYTE_SET) != 0;
+}
+
+static inline int cc_event_set(cc_event *p_event) {
+    if (CC__BYTE_PARKED & cc_atomic_exchange_u8(&p_event->state, CC__BYTE_SET, CC_MO_RELEASE))
+        cc_unpark_all(&p_event->state);
+    return 0;
+}
+
+static inline int cc_event_reset(cc_event *p_event) {
+    uint8_t expected = CC__BYTE_SET;
+    cc_atomic_cas_u8(&p_event->state, &expected, 0, CC_MO_RELAXED, CC_MO_RELAXED);
+    return 0;
+}
+
+/* NOTE: "p_abstime" is an absolute CLOCK_MONOTONIC deadline */
+static inline int cc_event_timedwait(cc_event *p_event, const struct timespec *p_abstime) {
+    uint8_t state = cc_atomic_load_u8(&p_event->state, CC_MO_ACQUIRE);
+    cc__park_byte check;
+
+    check.p_byte = &p_event->state;
+    check.expected = CC__BYTE_PARKED;
+    while (!(state & CC__BYTE_SET)) {
+        if (state & CC__BYTE_PARKED
+            || cc_atomic_cas_u8(&p_event->state, &state, CC__BYTE_PARKED, CC_MO_ACQUIRE, CC_MO_ACQUIRE)) {
+            if (ETIMEDOUT == cc_park(&p_event->state, cc__park_validate_byte, &check, p_abstime)) return ETIMEDOUT;
+            state = cc_atomic_load_u8(&p_event->state, CC_MO_ACQUIRE);
+        }
+    }
+    return 0;
+}
+
+static inline int cc_event_wait(cc_event *p_event) {
+    return cc_event_timedwait(p_event, NULL);
+}
+
+/* per-thread pool of queue lock nodes, kept in a TLS slot shared by every queue lock */
+CC__SHARED cc_tls_key cc__qnode_key = 0;
+CC__SHARED cc_once cc__qnode_key_once = CC_ONCE_INIT;
+
+static inline void cc__qnode_key_create(void) {
+    cc_tls_key_create(&cc__qnode_key);
+}
+
+static inline cc__qnode *cc__qnode_get(void) {
+    cc__qnode *p_node;
+
+    cc_call_once(&cc__qnode_key_once, cc__qnode_key_create);
+    p_node = (cc__qnode *)cc_tls_get(cc__qnode_key);
+    if (p_node) cc_tls_set(cc__qnode_key, p_node->p_pool_next);
+    else p_node = (cc__qnode *)cc__aligned_alloc(sizeof(cc__qnode));
+    return p_node;
+}
+
+static inline void cc__qnode_put(cc__qnode *p_node) {
+    p_node->p_pool_next = (cc__qnode *)cc_tls_get(cc__qnode_key);
+    cc_tls_set(cc__qnode_key, p_node);
+}
+
+/* NOTE: Use "cc_qlock_cleanup" before a thread exits to free its cached queue lock nodes */
+static inline void cc_qlock_cleanup(void) {
+    cc__qnode *p_node, *p_next;
+
+    cc_call_once(&cc__qnode_key_once, cc__qnode_key_create);
+    for (p_node = (cc__qnode *)cc_tls_get(cc__qnode_key); p_node; p_node = p_next) {
+        p_next = p_node->p_pool_next;
+        cc__aligned_free(p_node);
+    }
+    cc_tls_set(cc__qnode_key, NULL);
+}
+
+/* spins on the waiter's own flag, then parks on it (marking it 2 so the releaser knows to wake) */
+static inline void cc__qnode_wait(uint32_t *p_locked) {
+    uint32_t expected = 1;
+    int spin;
+
+    for (spin = 0; spin < CC_MTX_SPIN_MAX; spin++) {
+        if (0 == cc_atomic_load_u32(p_locked, CC_MO_ACQUIRE)) return;
+        cc__cpu_relax();
+    }
+    if (!cc_atomic_cas_u32(p_locked, &expected, 2, CC_MO_ACQUIRE, CC_MO_ACQUIRE) && 0 == expected) return;
+    while (0 != cc_atomic_load_u32(p_locked, CC_MO_ACQUIRE))
+        cc_wait(p_locked, 2, NULL);
+}
+
+static inline void cc__qnode_grant(uint32_t *p_locked) {
+    if (2 == cc_atomic_exchange_u32(p_locked, 0, CC_MO_RELEASE))
+        cc_wake_one(p_locked);
+}
+
+static inline int cc_mcs_lock_init(cc_mcs_lock *p_lock) {
+    if (!p_lock) return -1;
+    p_lock->p_tail = NULL;
+    p_lock->p_holder = NULL;
+    return 0;
+}
+
+static inline int cc_mcs_lock_destroy(cc_mcs_lock *p_lock) {
+    if (!p_lock) return -1;
+    if (cc_atomic_load_ptr((void **)&p_lock->p_tail, CC_MO_RELAXED)) return EBUSY;
+    return 0;
+}
+
+/* MCS: waiters form a FIFO linked list, each spinning on the flag of its own node */
+static inline int cc_mcs_lock_acquire(cc_mcs_lock *p_lock) {
+    cc__qnode *p_node = cc__qnode_get();
+    cc__qnode *p_pred;
+
+    if (!p_node) return -1;
+    p_node->p_next = NULL;
+    p_node->locked = 1;
+    p_pred = (cc__qnode *)cc_atomic_exchange_ptr((void **)&p_lock->p_tail, p_node, CC_MO_ACQ_REL);
+    if (p_pred) {
+        cc_atomic_store_ptr((void **)&p_pred->p_next, p_node, CC_MO_RELEASE);
+        cc__qnode_wait(&p_node->locked);
+    }
+    p_lock->p_holder = p_node;
+    return 0;
+}
+
+static inline int cc_mcs_lock_tryacquire(cc_mcs_lock *p_lock) {
+    cc__qnode *p_node = cc__qnode_get();
+    void *p_expected = NULL;
+
+    if (!p_node) return -1;
+    p_node->p_next = NULL;
+    if (!cc_atomic_cas_ptr((void **)&p_lock->p_tail, &p_expected, p_node, CC_MO_ACQUIRE, CC_MO_RELAXED)) {
+        cc__qnode_put(p_node);
+        return EBUSY;
+    }
+    p_lock->p_holder = p_node;
+    return 0;
+}
+
+static inline int cc_mcs_lock_release(cc_mcs_lock *p_lock) {
+    cc__qnode *p_node = p_lock->p_holder;
+    cc__qnode *p_next = (cc__qnode *)cc_atomic_load_ptr((void **)&p_node->p_next, CC_MO_ACQUIRE);
+    void *p_expected = p_node;
+
+    if (!p_next) {
+        if (cc_atomic_cas_ptr((void **)&p_lock->p_tail, &p_expected, NULL, CC_MO_RELEASE, CC_MO_RELAXED)) {
+            cc__qnode_put(p_node);
+            return 0;
+        }
+        /* a successor swapped the tail but hasn't linked itself yet */
+        while (!(p_next = (cc__qnode *)cc_atomic_load_ptr((void **)&p_node->p_next, CC_MO_ACQUIRE)))
+            cc__cpu_relax();
+    }
+    cc__qnode_grant(&p_next->locked);
+    cc__qnode_put(p_node);
+    return 0;
+}
+
+static inline int cc_clh_lock_init(cc_clh_lock *p_lock) {
+    if (!p_lock) return -1;
+    p_lock->p_tail = (cc__qnode *)cc__aligned_alloc(sizeof(cc__qnode));
+    if (!p_lock->p_tail) return -2;
+    p_lock->p_tail->locked = 0;
+    p_lock->p_holder = NULL;
+    p_lock->p_pred = NULL;
+    return 0;
+}
+
+static inline int cc_clh_lock_destroy(cc_clh_lock *p_lock) {
+    if (!p_lock) return -1;
+    if (0 != cc_atomic_load_u32(&p_lock->p_tail->locked, CC_MO_RELAXED)) return EBUSY;
+    cc__aligned_free(p_lock->p_tail);
+    p_lock->p_tail = NULL;
+    return 0;
+}
+
+/* CLH: every waiter spins on the flag of its predecessor's node, and recycles that node once it owns the lock */
+static inline int cc_clh_lock_acquire(cc_clh_lock *p_lock) {
+    cc__qnode *p_node = cc__qnode_get();
+    cc__qnode *p_pred;
+
+    if (!p_node) return -1;
+    p_node->locked = 1;
+    p_pred = (cc__qnode *)cc_atomic_exchange_ptr((void **)&p_lock->p_tail, p_node, CC_MO_ACQ_REL);
+    cc__qnode_wait(&p_pred->locked);
+    p_lock->p_holder = p_node;
+    p_lock->p_pred = p_pred;
+    return 0;
+}
+
+static inline int cc_clh_lock_release(cc_clh_lock *p_lock) {
+    cc__qnode *p_pred = p_lock->p_pred;
+    cc__qnode_grant(&p_lock->p_holder->locked);
+    cc__qnode_put(p_pred);
+    return 0;
+}
+
+/* fills the cpu -> node map of the lock, machines without topology information are a single node */
+static inline int cc__cohort_read_topology(cc_cohort_lock *p_lock) {
+#if defined(CC_POSIX) && defined(__linux__)
+    char path[64], buf[4096];
+    FILE *p_file;
+    char *p_cur, *p_end;
+    long first, last, cpu, conf = sysconf(_SC_NPROCESSORS_CONF);
+    uint32_t node;
+
+    p_lock->n_cpus = (conf > 0) ? (uint32_t)conf : 1;
+    p_lock->p_cpu_node = (uint32_t *)calloc(p_lock->n_cpus, sizeof(uint32_t));
+    if (!p_lock->p_cpu_node) return -2;
+
+    for (node = 0; node < CC_COHORT_MAX_NODES; node++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+        if (!(p_file = fopen(path, "r"))) continue;
+        if (fgets(buf, sizeof(buf), p_file)) {
+            p_lock->n_nodes = node + 1;
+            /* "0-3,8-11" */
+            for (p_cur = buf; ; p_cur = p_end + 1) {
+                first = strtol(p_cur, &p_end, 10);
+                if (p_end == p_cur) break;
+                last = first;
+                if ('-' == *p_end) last = strtol(p_end + 1, &p_end, 10);
+                for (cpu = first; cpu <= last && cpu < (long)p_lock->n_cpus; cpu++)
+                    p_lock->p_cpu_node[cpu] = node;
+                if (',' != *p_end) break;
+            }
+        }
+        fclose(p_file);
+    }
+    return 0;
+#elif defined(CC_POSIX)
+    p_lock->n_cpus = 1;
+    p_lock->p_cpu_node = (uint32_t *)calloc(1, sizeof(uint32_t));
+    return p_lock->p_cpu_node ? 0 : -2;
+#elif defined(CC_WINDOWS)
+    ULONG highest = 0;
+    UCHAR node;
+    uint32_t cpu;
+
+    p_lock->n_cpus = 64;  /* processor numbers within the current processor group */
+    p_lock->p_cpu_node = (uint32_t *)calloc(p_lock->n_cpus, sizeof(uint32_t));
+    if (!p_lock->p_cpu_node) return -2;
+    if (GetNumaHighestNodeNumber(&highest)) p_lock->n_nodes = (uint32_t)highest + 1;
+    if (p_lock->n_nodes > CC_COHORT_MAX_NODES) p_lock->n_nodes = CC_COHORT_MAX_NODES;
+    for (cpu = 0; cpu < p_lock->n_cpus; cpu++) {
+        if (GetNumaProcessorNode((UCHAR)cpu, &node) && node < p_lock->n_nodes) p_lock->p_cpu_node[cpu] = node;
+    }
+    return 0;
+#endif
+}
+
+static inline uint32_t cc__cohort_current_node(cc_cohort_lock *p_lock) {
+#if defined(CC_POSIX) && defined(__linux__)
+    int cpu = sched_getcpu();
+#elif defined(CC_POSIX)
+    int cpu = 0;
+#elif defined(CC_WINDOWS)
+    int cpu = (int)GetCurrentProcessorNumber();
+#endif
+    if (cpu < 0 || (uint32_t)cpu >= p_lock->n_cpus) return 0;
+    return p_lock->p_cpu_node[cpu];
+}
+
+/* NOTE: "handoff_max" bounds the local handoffs before the lock migrates to another node (0: CC_COHORT_HANDOFF_MAX) */
+static inline int cc_cohort_lock_init(cc_cohort_lock *p_lock, uint32_t handoff_max) {
+    uint32_t i;
+    int ret;
+
+    if (!p_lock) return -1;
+    cc_mtx_init(&p_lock->global);
+    p_lock->handoff_max = handoff_max ? handoff_max : CC_COHORT_HANDOFF_MAX;
+    p_lock->holder_node = 0;
+    p_lock->n_nodes = 1;
+    p_lock->p_nodes = NULL;
+    if (0 != (ret = cc__cohort_read_topology(p_lock))) return ret;
+
+    p_lock->p_nodes = (cc__cohort_node *)cc__aligned_alloc(p_lock->n_nodes * sizeof(cc__cohort_node));
+    if (!p_lock->p_nodes) {
+        free(p_lock->p_cpu_node);
+        return -2;
+    }
+    for (i = 0; i < p_lock->n_nodes; i++) {
+        cc_mcs_lock_init(&p_lock->p_nodes[i].local);
+        p_lock->p_nodes[i].global_held = 0;
+        p_lock->p_nodes[i].batch = 0;
+    }
+    return 0;
+}
+
+static inline int cc_cohort_lock_destroy(cc_cohort_lock *p_lock) {
+    if (!p_lock) return -1;
+    if (EBUSY == cc_mtx_destroy(&p_lock->global)) return EBUSY;
+    cc__aligned_free(p_lock->p_nodes);
+    free(p_lock->p_cpu_node);
+    p_lock->p_nodes = NULL;
+    p_lock->p_cpu_node = NULL;
+    return 0;
+}
+
+/*
+    Cohort lock (C-BO-MCS): threads first queue on the MCS lock of their NUMA node, the winner takes the global lock
+    unless the previous local owner passed it along. Migration across sockets happens at most every "handoff_max" times.
+*/
+static inline int cc_cohort_lock_acquire(cc_cohort_lock *p_lock) {
+    uint32_t node = cc__cohort_current_node(p_lock);
+    cc__cohort_node *p_node = &p_lock->p_nodes[node];
+    int ret;
+
+    if (0 != (ret = cc_mcs_lock_acquire(&p_node->local))) return ret;
+    if (!p_node->global_held) cc_mtx_lock(&p_lock->global);
+    p_lock->holder_node = node;
+    return 0;
+}
+
+static inline int cc_cohort_lock_release(cc_cohort_lock *p_lock) {
+    cc__cohort_node *p_node = &p_lock->p_nodes[p_lock->holder_node];
+    void *p_tail = cc_atomic_load_ptr((void **)&p_node->local.p_tail, CC_MO_ACQUIRE);
+
+    if (p_tail != (void *)p_node->local.p_holder && p_node->batch < p_lock->handoff_max) {
+        /* a thread of the same node is queued: hand the global lock over with the local one */
+        p_node->batch++;
+        p_node->global_held = 1;
+    }
+    else {
+        p_node->batch = 0;
+        p_node->global_held = 0;
+        cc_mtx_unlock(&p_lock->global);
+    }
+    return cc_mcs_lock_release(&p_node->local);
+}
+
+static inline int cc_seqlock_init(cc_seqlock *p_sl) {
+    if (!p_sl) return -1;
+    p_sl->seq = 0;
+    return 0;
+}
+
+/*
+    Waits for an even sequence (no writer inside), spinning first and then yielding the CPU.
+    Parking would need the readers to announce themselves to the write end, i.e. to write to the seqlock.
+*/
+static inline uint32_t cc__seqlock_wait_even(cc_seqlock *p_sl) {
+    uint32_t seq;
+    int spin = 0;
+
+    while ((seq = cc_atomic_load_u32(&p_sl->seq, CC_MO_ACQUIRE)) & 1) {
+        if (spin++ < CC_MTX_SPIN_MAX) cc__cpu_relax();
+        else cc__yield();
+    }
+    return seq;
+}
+
+/* NOTE: writers are serialized among themselves, readers never write to the seqlock */
+static inline int cc_seqlock_write_begin(cc_seqlock *p_sl) {
+    uint32_t seq;
+    do {
+        seq = cc__seqlock_wait_even(p_sl);
+    } while (!cc_atomic_cas_u32(&p_sl->seq, &seq, seq + 1, CC_MO_ACQUIRE, CC_MO_RELAXED));
+    /* the odd sequence must be visible before any of the protected stores */
+    cc_atomic_fence(CC_MO_RELEASE);
+    return 0;
+}
+
+/* NOTE: nobody parks on the sequence, so the write end never makes a syscall */
+static inline int cc_seqlock_write_end(cc_seqlock *p_sl) {
+    cc_atomic_fetch_add_u32(&p_sl->seq, 1, CC_MO_RELEASE);
+    return 0;
+}
+
+static inline uint32_t cc_seqlock_read_begin(cc_seqlock *p_sl) {
+    return cc__seqlock_wait_even(p_sl);
+}
+
+/* returns non-zero if a writer got in since "cc_seqlock_read_begin" returned "start", the read must be redone */
+static inline int cc_seqlock_read_retry(cc_seqlock *p_sl, uint32_t start) {
+    cc_atomic_fence(CC_MO_ACQUIRE);
+    return cc_atomic_load_u32(&p_sl->seq, CC_MO_RELAXED) != start;
+}
+
+/* racy copy made of relaxed atomic accesses (word by word when aligned), validated by the sequence */
+static inline void cc__seqlock_copy(void *p_dst, const void *p_src, size_t size) {
+    unsigned char *p_d = (unsigned char *)p_dst;
+    const unsigned char *p_s = (const unsigned char *)p_src;
+    size_t i = 0;
+
+    if (0 == ((uintptr_t)p_d % sizeof(uintptr_t)) && 0 == ((uintptr_t)p_s % sizeof(uintptr_t))) {
+        for (; i + sizeof(uintptr_t) <= size; i += sizeof(uintptr_t)) {
+#if defined(CC_POSIX)
+            __atomic_store_n((uintptr_t *)(void *)(p_d + i), __atomic_load_n((const uintptr_t *)(const void *)(p_s + i), __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+#elif defined(CC_WINDOWS)
+            *(volatile uintptr_t *)(p_d + i) = *(const volatile uintptr_t *)(p_s + i);
+#endif
+        }
+    }
+    for (; i < size; i++) {
+#if defined(CC_POSIX)
+        __atomic_store_n(p_d + i, __atomic_load_n(p_s + i, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+#elif defined(CC_WINDOWS)
+        *(volatile unsigned char *)(p_d + i) = *(const volatile unsigned char *)(p_s + i);
+#endif
+    }
+}
+
+/* optimistically copies the shared "p_src" into the private "p_dst", retrying until no writer interfered */
+static inline int cc_seqlock_read(cc_seqlock *p_sl, void *p_dst, const void *p_src, size_t size) {
+    uint32_t start;
+    do {
+        start = cc_seqlock_read_begin(p_sl);
+        cc__seqlock_copy(p_dst, p_src, size);
+    } while (cc_seqlock_read_retry(p_sl, start));
+    return 0;
+}
+
+/* publishes the private "p_src" into the shared "p_dst" */
+static inline int cc_seqlock_write(cc_seqlock *p_sl, void *p_dst, const void *p_src, size_t size) {
+    cc_seqlock_write_begin(p_sl);
+    cc__seqlock_copy(p_dst, p_src, size);
+    return cc_seqlock_write_end(p_sl);
+}
+
+
+static inline uint32_t cc__cpu_count(void) {
+#if defined(CC_POSIX)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (uint32_t)n : 1;
+#elif defined(CC_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0) ? (uint32_t)info.dwNumberOfProcessors : 1;
+#endif
+}
+
+/* TLS slot holding the "cc_pool" worker the calling thread is, if any */
+CC__SHARED cc_tls_key cc__pool_key = 0;
+CC__SHARED cc_once cc__pool_key_once = CC_ONCE_INIT;
+
+static inline void cc__pool_key_create(void) {
+    cc_tls_key_create(&cc__pool_key);
+}
+
+static inline cc__pool_worker *cc__pool_current(cc_pool *p_pool) {
+    cc__pool_worker *p_w;
+
+    cc_call_once(&cc__pool_key_once, cc__pool_key_create);
+    p_w = (cc__pool_worker *)cc_tls_get(cc__pool_key);
+    return (p_w && p_w->p_pool == p_pool) ? p_w : NULL;
+}
+
+static inline cc__task *cc__pool_task_alloc(cc__pool_worker *p_w) {
+    cc__task *p_task;
+
+    if (p_w && p_w->p_free) {
+        p_task = p_w->p_free;
+        p_w->p_free = p_task->p_next;
+        p_w->n_free--;
+        return p_task;
+    }
+    return (cc__task *)malloc(sizeof(cc__task));
+}
+
+static inline void cc__pool_task_free(cc__pool_worker *p_w, cc__task *p_task) {
+    if (p_w && p_w->n_free < CC_POOL_TASK_CACHE) {
+        p_task->p_next = p_w->p_free;
+        p_w->p_free = p_task;
+        p_w->n_free++;
+    }
+    else free(p_task);
+}
+
+/*
+    Chase-Lev work-stealing deque, with the C11 orderings of Le, Pop, Cohen and Zappa Nardelli (PPoPP 2013).
+    The buffer has a fixed size, a full deque makes the owner fall back to the shared queue.
+*/
+static inline int cc__deque_push(cc__pool_worker *p_w, cc__task *p_task) {
+    uint64_t b = cc_atomic_load_u64(&p_w->bottom, CC_MO_RELAXED);
+    uint64_t t = cc_atomic_load_u64(&p_w->top, CC_MO_ACQUIRE);
+
+    if (b - t >= CC_POOL_DEQUE_SIZE) return -1;
+    cc_atomic_store_ptr(&p_w->p_buf[b & (CC_POOL_DEQUE_SIZE - 1)], p_task, CC_MO_RELAXED);
+    cc_atomic_store_u64(&p_w->bottom, b + 1, CC_MO_RELEASE);
+    return 0;
+}
+
+/* owner only: takes the most recently pushed task (LIFO keeps its working set in cache) */
+static inline cc__task *cc__deque_pop(cc__pool_worker *p_w) {
+    uint64_t b = cc_atomic_load_u64(&p_w->bottom, CC_MO_RELAXED) - 1;
+    uint64_t t;
+    cc__task *p_task = NULL;
+
+    cc_atomic_store_u64(&p_w->bottom, b, CC_MO_RELAXED);
+    cc_atomic_fence(CC_MO_SEQ_CST);
+    t = cc_atomic_load_u64(&p_w->top, CC_MO_RELAXED);
+    if ((int64_t)(b - t) >= 0) {
+        p_task = (cc__task *)cc_atomic_load_ptr(&p_w->p_buf[b & (CC_POOL_DEQUE_SIZE - 1)], CC_MO_RELAXED);
+        if (b == t) {
+            /* last task: race the thieves for it */
+            if (!cc_atomic_cas_u64(&p_w->top, &t, t + 1, CC_MO_SEQ_CST, CC_MO_RELAXED)) p_task = NULL;
+            cc_atomic_store_u64(&p_w->bottom, b + 1, CC_MO_RELAXED);
+        }
+    }
+    else cc_atomic_store_u64(&p_w->bottom, b + 1, CC_MO_RELAXED);
+    return p_task;
+}
+
+/* any thread: takes the oldest task, NULL if the deque is empty or another thief won the race */
+static inline cc__task *cc__deque_steal(cc__pool_worker *p_w) {
+    uint64_t t = cc_atomic_load_u64(&p_w->top, CC_MO_ACQUIRE);
+    uint64_t b;
+    cc__task *p_task;
+
+    cc_atomic_fence(CC_MO_SEQ_CST);
+    b = cc_atomic_load_u64(&p_w->bottom, CC_MO_ACQUIRE);
+    if ((int64_t)(b - t) <= 0) return NULL;
+    p_task = (cc__task *)cc_atomic_load_ptr(&p_w->p_buf[t & (CC_POOL_DEQUE_SIZE - 1)], CC_MO_RELAXED);
+    if (!cc_atomic_cas_u64(&p_w->top, &t, t + 1, CC_MO_SEQ_CST, CC_MO_RELAXED)) return NULL;
+    return p_task;
+}
+
+static inline void cc__pool_inject(cc_pool *p_pool, cc__task *p_task) {
+    p_task->p_next = NULL;
+    cc_mtx_lock(&p_pool->inject_mtx);
+    if (p_pool->p_inject_tail) p_pool->p_inject_tail->p_next = p_task;
+    else p_pool->p_inject_head = p_task;
+    p_pool->p_inject_tail = p_task;
+    cc_atomic_fetch_add_u32(&p_pool->n_inject, 1, CC_MO_RELAXED);
+    cc_mtx_unlock(&p_pool->inject_mtx);
+}
+
+static inline cc__task *cc__pool_inject_pop(cc_pool *p_pool) {
+    cc__task *p_task;
+
+    if (0 == cc_atomic_load_u32(&p_pool->n_inject, CC_MO_ACQUIRE)) return NULL;
+    cc_mtx_lock(&p_pool->inject_mtx);
+    p_task = p_pool->p_inject_head;
+    if (p_task) {
+        p_pool->p_inject_head = p_task->p_next;
+        if (!p_pool->p_inject_head) p_pool->p_inject_tail = NULL;
+        cc_atomic_fetch_sub_u32(&p_pool->n_inject, 1, CC_MO_RELAXED);
+    }
+    cc_mtx_unlock(&p_pool->inject_mtx);
+    return p_task;
+}
+
+/* own deque first, then the shared queue, then the other workers starting from a random victim */
+static inline cc__task *cc__pool_find(cc_pool *p_pool, cc__pool_worker *p_w) {
+    cc__task *p_task = p_w ? cc__deque_pop(p_w) : NULL;
+    uint32_t i, start = 0, n = p_pool->n_workers;
+
+    if (p_task) return p_task;
+    if ((p_task = cc__pool_inject_pop(p_pool))) return p_task;
+    if (p_w) {
+        /* xorshift32 */
+        p_w->rng ^= p_w->rng << 13;
+        p_w->rng ^= p_w->rng >> 17;
+        p_w->rng ^= p_w->rng << 5;
+        start = p_w->rng % n;
+    }
+    for (i = 0; i < n; i++) {
+        cc__pool_worker *p_victim = &p_pool->p_workers[(start + i) % n];
+        if (p_victim == p_w) continue;
+        if ((p_task = cc__deque_steal(p_victim))) return p_task;
+    }
+    return NULL;
+}
+
+static inline int cc__pool_has_work(cc_pool *p_pool) {
+    uint32_t i;
+
+    if (0 != cc_atomic_load_u32(&p_pool->n_inject, CC_MO_SEQ_CST)) return 1;
+    for (i = 0; i < p_pool->n_workers; i++) {
+        cc__pool_worker *p_w = &p_pool->p_workers[i];
+        if ((int64_t)(cc_atomic_load_u64(&p_w->bottom, CC_MO_SEQ_CST) - cc_atomic_load_u64(&p_w->top, CC_MO_SEQ_CST)) > 0)
+            return 1;
+    }
+    return 0;
+}
+
+/* wakes one sleeping worker after a push, free when every worker is busy or spinning */
+static inline void cc__pool_notify(cc_pool *p_pool) {
+    cc_atomic_fence(CC_MO_SEQ_CST);
+    if (0 != cc_atomic_load_u32(&p_pool->sleepers, CC_MO_RELAXED)) {
+        cc_atomic_fetch_add_u32(&p_pool->sleep_seq, 1, CC_MO_RELEASE);
+        cc_wake_one(&p_pool->sleep_seq);
+    }
+}
+
+static inline void cc__pool_run(cc_pool *p_pool, cc__pool_worker *p_w, cc__task *p_task) {
+    void (*func)(void *arg) = p_task->func;
+    void *arg = p_task->arg;
+    cc_task_group *p_group = p_task->p_group;
+
+    /* recycled before running, so the tasks it spawns reuse the node while it's still in cache */
+    cc__pool_task_free(p_w, p_task);
+    func(arg);
+    /* the group may be gone as soon as its count drops, only its address is used for the wake */
+    if (p_group && (CC__TASK_GROUP_WAITING | 1) == cc_atomic_fetch_sub_u32(&p_group->pending, 1, CC_MO_ACQ_REL))
+        cc_wake_all(&p_group->pending);
+    if (1 == cc_atomic_fetch_sub_u32(&p_pool->pending, 1, CC_MO_SEQ_CST)
+        && 0 != cc_atomic_load_u32(&p_pool->waiters, CC_MO_SEQ_CST))
+        cc_wake_all(&p_pool->pending);
+}
+
+#define CC__POOL_SLOT_FREE      0U
+#define CC__POOL_SLOT_LIVE      1U
+#define CC__POOL_SLOT_RETIRED   2U  /* the thread exited (or is exiting) and still has to be joined */
+
+/*
+    An idle elastic worker leaves if that keeps the pool at or above its minimum. Work submitted meanwhile
+    either sees the lower live count and spawns, or is seen here and the worker stays.
+*/
+static inline int cc__pool_retire(cc_pool *p_pool) {
+    uint32_t live = cc_atomic_load_u32(&p_pool->n_live, CC_MO_RELAXED);
+
+    do {
+        if (live <= p_pool->min_workers) return 0;
+    } while (!cc_atomic_cas_u32(&p_pool->n_live, &live, live - 1, CC_MO_SEQ_CST, CC_MO_RELAXED));
+    cc_atomic_fence(CC_MO_SEQ_CST);
+    if (!cc__pool_has_work(p_pool)) return 1;
+    cc_atomic_fetch_add_u32(&p_pool->n_live, 1, CC_MO_RELAXED);
+    return 0;
+}
+
+/*
+    Hands the slot of a retiring worker over to "cc__pool_spawn", then looks for work once more: a submit that
+    found the slot still live could not spawn, so the worker takes its slot back unless a spawner claimed it.
+*/
+static inline int cc__pool_rejoin(cc_pool *p_pool, cc__pool_worker *p_w) {
+    uint32_t state = CC__POOL_SLOT_RETIRED;
+
+    cc_atomic_store_u32(&p_w->state, CC__POOL_SLOT_RETIRED, CC_MO_SEQ_CST);
+    cc_atomic_fence(CC_MO_SEQ_CST);
+    if (!cc__pool_has_work(p_pool) || cc_atomic_load_u32(&p_pool->stop, CC_MO_ACQUIRE)) return 0;
+    if (!cc_atomic_cas_u32(&p_w->state, &state, CC__POOL_SLOT_LIVE, CC_MO_SEQ_CST, CC_MO_RELAXED)) return 0;
+    cc_atomic_fetch_add_u32(&p_pool->n_live, 1, CC_MO_SEQ_CST);
+    return 1;
+}
+
+static CC__NOINLINE int cc__pool_spawn(cc_pool *p_pool);
+
+/* elastic pools: a backlog while no worker is idle gets one more worker */
+static inline void cc__pool_grow(cc_pool *p_pool) {
+    uint32_t live = cc_atomic_load_u32(&p_pool->n_live, CC_MO_SEQ_CST);
+
+    if (live >= p_pool->n_workers) return;
+    if (0 == live || (0 == cc_atomic_load_u32(&p_pool->sleepers, CC_MO_SEQ_CST)
+                      && cc_atomic_load_u32(&p_pool->pending, CC_MO_RELAXED) > live))
+        cc__pool_spawn(p_pool);
+}
+
+static CC_TH_FUNC_RET cc__pool_worker_main(void *arg) {
+    cc__pool_worker *p_w = (cc__pool_worker *)arg;
+    cc_pool *p_pool = p_w->p_pool;
+    cc__task *p_task;
+    struct timespec deadline, *p_deadline = NULL;
+    uint32_t seq;
+    int spin = 0, timed_out = 0;
+
+    cc_call_once(&cc__pool_key_once, cc__pool_key_create);
+    cc_tls_set(cc__pool_key, p_w);
+    for (;;) {
+        if ((p_task = cc__pool_find(p_pool, p_w))) {
+            /* a backlog submitted while this worker still counted as a sleeper is caught here */
+            if (p_pool->min_workers < p_pool->n_workers) cc__pool_grow(p_pool);
+            cc__pool_run(p_pool, p_w, p_task);
+            spin = 0;
+            continue;
+        }
+        if (cc_atomic_load_u32(&p_pool->stop, CC_MO_ACQUIRE)) break;
+        if (spin++ < CC_POOL_SPIN_MAX) {
+            cc__cpu_relax();
+            continue;
+        }
+        /* announce the sleep, then re-check: a submitter either sees the sleeper or we see its task */
+        seq = cc_atomic_load_u32(&p_pool->sleep_seq, CC_MO_ACQUIRE);
+        cc_atomic_fetch_add_u32(&p_pool->sleepers, 1, CC_MO_SEQ_CST);
+        if (!cc__pool_has_work(p_pool) && !cc_atomic_load_u32(&p_pool->stop, CC_MO_SEQ_CST)) {
+            if (p_pool->min_workers < p_pool->n_workers) {
+                cc_time_monotonic(&deadline);
+                cc_time_add_ms(&deadline, p_pool->idle_ms);
+                p_deadline = &deadline;
+            }
+            timed_out = (ETIMEDOUT == cc_wait(&p_pool->sleep_seq, seq, p_deadline));
+        }
+        cc_atomic_fetch_sub_u32(&p_pool->sleepers, 1, CC_MO_SEQ_CST);
+        spin = 0;
+        if (timed_out && cc__pool_retire(p_pool) && !cc__pool_rejoin(p_pool, p_w)) break;
+        timed_out = 0;
+    }
+
+    while ((p_task = p_w->p_free)) {
+        p_w->p_free = p_task->p_next;
+        free(p_task);
+    }
+    p_w->n_free = 0;
+    cc_tls_set(cc__pool_key, NULL);
+    CC_TH_RETURN(0);
+}
+
+/* starts a worker in a free slot, claiming a retired one from its exiting thread and joining that first */
+static CC__NOINLINE int cc__pool_spawn(cc_pool *p_pool) {
+    cc__pool_worker *p_w = NULL;
+    cc_th_attr attr;
+    int ret = -1, has_attr = 0;
+    uint32_t i, state = CC__POOL_SLOT_FREE;
+
+    /* blocking: a spawner still holding the lock may have found no slot to reuse yet */
+    cc_mtx_lock(&p_pool->grow_mtx);
+    if (!p_pool->stop && cc_atomic_load_u32(&p_pool->n_live, CC_MO_SEQ_CST) < p_pool->n_workers) {
+        for (i = 0; i < p_pool->n_workers && !p_w; i++) {
+            state = cc_atomic_load_u32(&p_pool->p_workers[i].state, CC_MO_SEQ_CST);
+            if (CC__POOL_SLOT_LIVE == state) continue;
+            if (CC__POOL_SLOT_RETIRED == state
+                && !cc_atomic_cas_u32(&p_pool->p_workers[i].state, &state, CC__POOL_SLOT_FREE, CC_MO_SEQ_CST, CC_MO_ACQUIRE))
+                continue;  /* its worker took it back */
+            p_w = &p_pool->p_workers[i];
+        }
+    }
+    if (p_w) {
+        if (CC__POOL_SLOT_RETIRED == state) cc_th_join(p_w->th, NULL);
+        cc_atomic_store_u32(&p_w->state, CC__POOL_SLOT_FREE, CC_MO_RELAXED);
+        if (!p_w->p_buf) p_w->p_buf = (void **)calloc(CC_POOL_DEQUE_SIZE, sizeof(void *));
+        ret = -2;
+    }
+    if (p_w && p_w->p_buf) {
+        if (p_pool->stack_size && 0 == cc_th_attr_init(&attr)) {
+            has_attr = 1;
+            cc_th_attr_setstacksize(&attr, p_pool->stack_size);
+        }
+        cc_atomic_store_u32(&p_w->state, CC__POOL_SLOT_LIVE, CC_MO_RELAXED);
+        cc_atomic_fetch_add_u32(&p_pool->n_live, 1, CC_MO_SEQ_CST);
+        if (0 == cc_th_create(&p_w->th, has_attr ? &attr : NULL, cc__pool_worker_main, p_w)) ret = 0;
+        else {
+            cc_atomic_fetch_sub_u32(&p_pool->n_live, 1, CC_MO_RELAXED);
+            cc_atomic_store_u32(&p_w->state, CC__POOL_SLOT_FREE, CC_MO_RELAXED);
+        }
+        if (has_attr) cc_th_attr_destroy(&attr);
+    }
+    cc_mtx_unlock(&p_pool->grow_mtx);
+    return ret;
+}
+
+/* stops the workers and joins every thread, running or retired */
+static inline void cc__pool_stop(cc_pool *p_pool) {
+    uint32_t i;
+
+    cc_mtx_lock(&p_pool->grow_mtx);
+    cc_atomic_store_u32(&p_pool->stop, 1, CC_MO_SEQ_CST);
+    cc_mtx_unlock(&p_pool->grow_mtx);
+    cc_atomic_fetch_add_u32(&p_pool->sleep_seq, 1, CC_MO_SEQ_CST);
+    cc_wake_all(&p_pool->sleep_seq);
+    for (i = 0; i < p_pool->n_workers; i++) {
+        if (CC__POOL_SLOT_FREE == cc_atomic_load_u32(&p_pool->p_workers[i].state, CC_MO_ACQUIRE)) continue;
+        cc_th_join(p_pool->p_workers[i].th, NULL);
+        p_pool->p_workers[i].state = CC__POOL_SLOT_FREE;
+    }
+}
+
+static inline void cc__pool_free(cc_pool *p_pool) {
+    uint32_t i;
+
+    for (i = 0; i < p_pool->n_workers; i++) free((void *)p_pool->p_workers[i].p_buf);
+    cc__aligned_free(p_pool->p_workers);
+    p_pool->p_workers = NULL;
+}
+
+static inline int cc__pool_init(cc_pool *p_pool, uint32_t min_workers, uint32_t n_workers, uint32_t idle_ms, size_t stack_size) {
+    uint32_t i;
+
+    p_pool->n_workers = n_workers;
+    p_pool->min_workers = min_workers;
+    p_pool->idle_ms = idle_ms;
+    p_pool->stop = 0;
+    p_pool->stack_size = stack_size;
+    p_pool->pending = 0;
+    p_pool->waiters = 0;
+    p_pool->sleep_seq = 0;
+    p_pool->sleepers = 0;
+    p_pool->n_live = 0;
+    cc_mtx_init(&p_pool->grow_mtx);
+    cc_mtx_init(&p_pool->inject_mtx);
+    p_pool->n_inject = 0;
+    p_pool->p_inject_head = NULL;
+    p_pool->p_inject_tail = NULL;
+    p_pool->p_workers = (cc__pool_worker *)cc__aligned_alloc(n_workers * sizeof(cc__pool_worker));
+    if (!p_pool->p_workers) return -2;
+
+    for (i = 0; i < n_workers; i++) {
+        cc__pool_worker *p_w = &p_pool->p_workers[i];
+        p_w->top = 0;
+        p_w->bottom = 0;
+        p_w->p_buf = NULL;  /* allocated with the slot's first thread */
+        p_w->p_free = NULL;
+        p_w->n_free = 0;
+        p_w->rng = (i + 1) * 2654435761U;
+        p_w->state = CC__POOL_SLOT_FREE;
+        p_w->p_pool = p_pool;
+    }
+    for (i = 0; i < min_workers; i++) {
+        if (0 != cc__pool_spawn(p_pool)) {
+            cc__pool_stop(p_pool);
+            cc__pool_free(p_pool);
+            return -2;
+        }
+    }
+    return 0;
+}
+
+/* work-stealing pool of "n_workers" threads (0: one per online cpu) */
+static inline int cc_pool_init(cc_pool *p_pool, uint32_t n_workers) {
+    if (!p_pool) return -1;
+    if (0 == n_workers) n_workers = cc__cpu_count();
+    return cc__pool_init(p_pool, n_workers, n_workers, 0, 0);
+}
+
+/*
+    Elastic pool: starts "min_workers" and spawns more, up to "max_workers" (0: one per online cpu), while tasks
+    queue up with no worker idle. Workers above the minimum exit after "idle_ms" without work, their threads
+    are joined when the slot is reused or at shutdown. Threads get "stack_size" bytes of stack (0: CC_POOL_STACK_SIZE).
+*/
+static inline int cc_pool_init_elastic(cc_pool *p_pool, uint32_t min_workers, uint32_t max_workers, uint32_t idle_ms, size_t stack_size) {
+    if (!p_pool) return -1;
+    if (0 == max_workers) max_workers = cc__cpu_count();
+    if (min_workers > max_workers) return -1;
+    return cc__pool_init(p_pool, min_workers, max_workers, idle_ms, stack_size ? stack_size : CC_POOL_STACK_SIZE);
+}
+
+static inline int cc__pool_submit(cc_pool *p_pool, void (*func)(void *arg), void *arg, cc_task_group *p_group) {
+    cc__pool_worker *p_w;
+    cc__task *p_task;
+
+    if (!p_pool || !func || cc_atomic_load_u32(&p_pool->stop, CC_MO_RELAXED)) return -1;
+    p_w = cc__pool_current(p_pool);
+    if (!(p_task = cc__pool_task_alloc(p_w))) return -2;
+    p_task->func = func;
+    p_task->arg = arg;
+    p_task->p_group = p_group;
+
+    if (p_group) cc_atomic_fetch_add_u32(&p_group->pending, 1, CC_MO_RELAXED);
+    cc_atomic_fetch_add_u32(&p_pool->pending, 1, CC_MO_RELAXED);
+    if (!p_w || 0 != cc__deque_push(p_w, p_task)) cc__pool_inject(p_pool, p_task);
+    cc__pool_notify(p_pool);
+    if (p_pool->min_workers < p_pool->n_workers) cc__pool_grow(p_pool);
+    return 0;
+}
+
+/*
+    Queues "func(arg)": a worker of the pool pushes onto its own deque, other threads onto the shared queue.
+    Returns -1 once the pool is shut down.
+*/
+static inline int cc_pool_submit(cc_pool *p_pool, void (*func)(void *arg), void *arg) {
+    return cc__pool_submit(p_pool, func, arg, NULL);
+}
+
+/* NOTE: waits for every task submitted so far and the ones they spawn, a pool task can't wait for its own pool */
+static inline int cc_pool_wait(cc_pool *p_pool) {
+    uint32_t pending;
+
+    if (!p_pool) return -1;
+    if (cc__pool_current(p_pool)) return EDEADLK;
+    cc_atomic_fetch_add_u32(&p_pool->waiters, 1, CC_MO_SEQ_CST);
+    while (0 != (pending = cc_atomic_load_u32(&p_pool->pending, CC_MO_SEQ_CST)))
+        cc_wait(&p_pool->pending, pending, NULL);
+    cc_atomic_fetch_sub_u32(&p_pool->waiters, 1, CC_MO_RELAXED);
+    return 0;
+}
+
+/* drains the queued tasks, then stops and joins the workers */
+static inline int cc_pool_shutdown(cc_pool *p_pool) {
+    int err;
+
+    if (!p_pool) return -1;
+    if (!p_pool->p_workers || cc_atomic_load_u32(&p_pool->stop, CC_MO_ACQUIRE)) return 0;
+    if (0 != (err = cc_pool_wait(p_pool))) return err;
+    cc__pool_stop(p_pool);
+    return 0;
+}
+
+static inline int cc_pool_destroy(cc_pool *p_pool) {
+    int err;
+
+    if (!p_pool) return -1;
+    if (0 != (err = cc_pool_shutdown(p_pool))) return err;
+    if (p_pool->p_workers) cc__pool_free(p_pool);
+    return 0;
+}
+
+static inline int cc_task_group_init(cc_task_group *p_group, cc_pool *p_pool) {
+    if (!p_group || !p_pool) return -1;
+    p_group->p_pool = p_pool;
+    p_group->pending = 0;
+    return 0;
+}
+
+static inline int cc_task_group_destroy(cc_task_group *p_group) {
+    if (!p_group) return -1;
+    if (0 != (cc_atomic_load_u32(&p_group->pending, CC_MO_ACQUIRE) & ~CC__TASK_GROUP_WAITING)) return EBUSY;
+    return 0;
+}
+
+/* NOTE: can be called from the group's own tasks, to fork recursively */
+static inline int cc_task_group_run(cc_task_group *p_group, void (*func)(void *arg), void *arg) {
+    if (!p_group) return -1;
+    return cc__pool_submit(p_group->p_pool, func, arg, p_group);
+}
+
+/*
+    Waits for every task run through the group, executing pool tasks meanwhile instead of blocking:
+    the caller's own deque first (its children), then the shared queue and steals. It only sleeps once
+    nothing is left to take, the missing tasks are then running on other threads.
+    NOTE: safe from inside pool tasks, recursive fork-join never holds a worker idle. Unrelated tasks may run
+    on the caller's stack.
+*/
+static inline int cc_task_group_wait(cc_task_group *p_group) {
+    cc_pool *p_pool;
+    cc__pool_worker *p_w;
+    cc__task *p_task;
+    uint32_t pending;
+    int spin = 0;
+
+    if (!p_group) return -1;
+    p_pool = p_group->p_pool;
+    p_w = cc__pool_current(p_pool);
+    while (0 != ((pending = cc_atomic_load_u32(&p_group->pending, CC_MO_ACQUIRE)) & ~CC__TASK_GROUP_WAITING)) {
+        if ((p_task = cc__pool_find(p_pool, p_w))) {
+            cc__pool_run(p_pool, p_w, p_task);
+            spin = 0;
+            continue;
+        }
+        if (spin++ < CC_POOL_SPIN_MAX) {
+            cc__cpu_relax();
+            continue;
+        }
+        if (!(pending & CC__TASK_GROUP_WAITING)
+            && !cc_atomic_cas_u32(&p_group->pending, &pending, pending | CC__TASK_GROUP_WAITING, CC_MO_ACQUIRE, CC_MO_ACQUIRE))
+            continue;
+        cc_wait(&p_group->pending, pending | CC__TASK_GROUP_WAITING, NULL);
+        spin = 0;
+    }
+    /* leave the group reusable without wakeups, unless new tasks came in meanwhile */
+    pending = CC__TASK_GROUP_WAITING;
+    cc_atomic_cas_u32(&p_group->pending, &pending, 0, CC_MO_RELAXED, CC_MO_RELAXED);
+    return 0;
+}
+
+static inline int cc__pool_executor_submit(void *ctx, void (*func)(void *arg), void *arg) {
+    return cc_pool_submit((cc_pool *)ctx, func, arg);
+}
+
+static inline cc_executor cc_pool_executor(cc_pool *p_pool) {
+    cc_executor exec;
+    exec.submit = cc__pool_executor_submit;
+    exec.ctx = p_pool;
+    return exec;
+}
+
+#define CC__FUTURE_SETTING  1U
+#define CC__FUTURE_READY    2U
+#define CC__FUTURE_WAITING  4U  /* threads sleep on "state" */
+
+/* "p_conts" of a ready future: continuations registered later run right away */
+#define CC__FUTURE_CLOSED(p_future)     ((cc_continuation *)(void *)&(p_future)->p_conts)
+
+static inline int cc_future_init(cc_future *p_future) {
+    if (!p_future) return -1;
+    p_future->state = 0;
+    p_future->remaining = 0;
+    p_future->error = 0;
+    p_future->value = NULL;
+    p_future->p_conts = NULL;
+    return 0;
+}
+
+static inline int cc_future_is_ready(cc_future *p_future) {
+    return 0 != (cc_atomic_load_u32(&p_future->state, CC_MO_ACQUIRE) & CC__FUTURE_READY);
+}
+
+static inline void cc__future_complete(cc_future *p_future, void *value, int error);
+
+static inline void cc__future_cont_run(void *arg) {
+    cc_continuation *p_cont = (cc_continuation *)arg;
+    cc_future *p_dst = p_cont->p_dst;
+    void *result = NULL;
+    int error = p_cont->func(p_cont->p_src, p_cont->arg, &result);
+
+    if (p_dst) cc__future_complete(p_dst, result, error);
+}
+
+static inline void cc__future_cont_dispatch(cc_continuation *p_cont) {
+    if (p_cont->p_exec && 0 == p_cont->p_exec->submit(p_cont->p_exec->ctx, cc__future_cont_run, p_cont)) return;
+    cc__future_cont_run(p_cont);
+}
+
+/* publishes the result, wakes the waiters and runs the continuations in registration order */
+static inline void cc__future_complete(cc_future *p_future, void *value, int error) {
+    cc_continuation *p_cont, *p_next, *p_ordered = NULL;
+
+    p_future->value = value;
+    p_future->error = error;
+    /* closed before READY is published: a ready future runs new continuations inline, and its
+       owner may free it as soon as READY is seen, only its address is used for the wake */
+    p_cont = (cc_continuation *)cc_atomic_exchange_ptr((void **)&p_future->p_conts, CC__FUTURE_CLOSED(p_future), CC_MO_ACQ_REL);
+    if (CC__FUTURE_WAITING & cc_atomic_exchange_u32(&p_future->state, CC__FUTURE_READY, CC_MO_ACQ_REL))
+        cc_wake_all(&p_future->state);
+
+    for (; p_cont; p_cont = p_next) {
+        p_next = p_cont->p_next;
+        p_cont->p_next = p_ordered;
+        p_ordered = p_cont;
+    }
+    for (p_cont = p_ordered; p_cont; p_cont = p_next) {
+        p_next = p_cont->p_next;
+        cc__future_cont_dispatch(p_cont);
+    }
+}
+
+/* NOTE: "p_abstime" is an absolute CLOCK_MONOTONIC deadline, NULL waits forever */
+static inline int cc_future_timedwait(cc_future *p_future, const struct timespec *p_abstime) {
+    uint32_t state;
+
+    if (!p_future) return -1;
+    for (;;) {
+        state = cc_atomic_load_u32(&p_future->state, CC_MO_ACQUIRE);
+        if (state & CC__FUTURE_READY) return 0;
+        if (!(state & CC__FUTURE_WAITING)
+            && !cc_atomic_cas_u32(&p_future->state, &state, state | CC__FUTURE_WAITING, CC_MO_ACQUIRE, CC_MO_ACQUIRE))
+            continue;
+        if (ETIMEDOUT == cc_wait(&p_future->state, state | CC__FUTURE_WAITING, p_abstime)) {
+            return cc_future_is_ready(p_future) ? 0 : ETIMEDOUT;
+        }
+    }
+}
+
+/* NOTE: blocks the calling thread, from a pool task prefer "cc_future_then" */
+static inline int cc_future_wait(cc_future *p_future) {
+    return cc_future_timedwait(p_future, NULL);
+}
+
+/* waits for the future, stores its value in "*p_value" (if not NULL) and returns its error */
+static inline int cc_future_get(cc_future *p_future, void **p_value) {
+    int ret = cc_future_wait(p_future);
+
+    if (0 != ret) return ret;
+    if (p_value) *p_value = p_future->value;
+    return p_future->error;
+}
+
+static inline int cc_promise_init(cc_promise *p_promise, cc_future *p_future) {
+    if (!p_promise || !p_future) return -1;
+    p_promise->p_future = p_future;
+    return cc_future_init(p_future);
+}
+
+static inline int cc__promise_set(cc_promise *p_promise, void *value, int error) {
+    uint32_t state;
+
+    if (!p_promise || !p_promise->p_future) return -1;
+    state = cc_atomic_load_u32(&p_promise->p_future->state, CC_MO_RELAXED);
+    do {
+        if (state & (CC__FUTURE_SETTING | CC__FUTURE_READY)) return -1;
+    } while (!cc_atomic_cas_u32(&p_promise->p_future->state, &state, state | CC__FUTURE_SETTING, CC_MO_ACQUIRE, CC_MO_RELAXED));
+    cc__future_complete(p_promise->p_future, value, error);
+    return 0;
+}
+
+/* returns -1 if the promise was already fulfilled */
+static inline int cc_promise_set_value(cc_promise *p_promise, void *value) {
+    return cc__promise_set(p_promise, value, 0);
+}
+
+/* "error" is what "cc_future_get" returns, non-zero */
+static inline int cc_promise_set_error(cc_promise *p_promise, int error) {
+    if (0 == error) return -1;
+    return cc__promise_set(p_promise, NULL, error);
+}
+
+/* registers "p_cont" on "p_src", or dispatches it right away if the source is already ready */
+static inline void cc__future_attach(cc_future *p_src, cc_continuation *p_cont) {
+    cc_continuation *p_head = (cc_continuation *)cc_atomic_load_ptr((void **)&p_src->p_conts, CC_MO_ACQUIRE);
+
+    p_cont->p_src = p_src;
+    do {
+        if (p_head == CC__FUTURE_CLOSED(p_src)) {
+            cc__future_cont_dispatch(p_cont);
+            return;
+        }
+        p_cont->p_next = p_head;
+    } while (!cc_atomic_cas_ptr((void **)&p_src->p_conts, (void **)&p_head, p_cont, CC_MO_ACQ_REL, CC_MO_ACQUIRE));
+}
+
+/*
+    Runs "func(p_src, arg, &result)" once "p_src" is ready, inline on the completing thread or through "p_exec",
+    then completes "p_dst" (if not NULL, it is initialized here) with "result" and the returned error, so
+    continuations chain. NOTE: "p_cont" (and "p_exec") must stay valid until the continuation has run.
+*/
+static inline int cc_future_then(cc_future *p_src, cc_continuation *p_cont, int (*func)(cc_future *p_src, void *arg, void **p_result), void *arg, const cc_executor *p_exec, cc_future *p_dst) {
+    if (!p_src || !p_cont || !func) return -1;
+    if (p_dst) cc_future_init(p_dst);
+    p_cont->func = func;
+    p_cont->arg = arg;
+    p_cont->p_exec = p_exec;
+    p_cont->p_dst = p_dst;
+    cc__future_attach(p_src, p_cont);
+    return 0;
+}
+
+static inline int cc__future_when_all_step(cc_future *p_src, void *arg, void **p_result) {
+    cc_future *p_dst = (cc_future *)arg;
+    int no_error = 0;
+    (void)p_result;
+
+    if (0 != p_src->error) cc_atomic_cas_u32((uint32_t *)&p_dst->error, (uint32_t *)&no_error, (uint32_t)p_src->error, CC_MO_RELAXED, CC_MO_RELAXED);
+    if (1 == cc_atomic_fetch_sub_u32(&p_dst->remaining, 1, CC_MO_ACQ_REL))
+        cc__future_complete(p_dst, NULL, p_dst->error);
+    return 0;
+}
+
+static inline int cc__future_when_any_step(cc_future *p_src, void *arg, void **p_result) {
+    cc_future *p_dst = (cc_future *)arg;
+    uint32_t expected = 1;
+    (void)p_result;
+
+    if (cc_atomic_cas_u32(&p_dst->remaining, &expected, 0, CC_MO_ACQ_REL, CC_MO_RELAXED))
+        cc__future_complete(p_dst, p_src, p_src->error);
+    return 0;
+}
+
+static inline int cc__future_when(cc_future *p_dst, cc_future **pp_src, size_t n, cc_continuation *p_conts, int all) {
+    size_t i;
+
+    if (!p_dst || (n && (!pp_src || !p_conts)) || n > UINT32_MAX) return -1;
+    cc_future_init(p_dst);
+    if (0 == n) {
+        cc__future_complete(p_dst, NULL, 0);
+        return 0;
+    }
+    p_dst->remaining = all ? (uint32_t)n : 1;
+    for (i = 0; i < n; i++) {
+        p_conts[i].func = all ? cc__future_when_all_step : cc__future_when_any_step;
+        p_conts[i].arg = p_dst;
+        p_conts[i].p_exec = NULL;
+        p_conts[i].p_dst = NULL;
+    }
+    for (i = 0; i < n; i++) cc__future_attach(pp_src[i], &p_conts[i]);
+    return 0;
+}
+
+/* completes "p_dst" once all "n" futures are ready, with the first error among them ("p_conts": n slots) */
+static inline int cc_future_when_all(cc_future *p_dst, cc_future **pp_src, size_t n, cc_continuation *p_conts) {
+    return cc__future_when(p_dst, pp_src, n, p_conts, 1);
+}
+
+/* completes "p_dst" with the first of the "n" futures to be ready as value, and its error ("p_conts": n slots) */
+static inline int cc_future_when_any(cc_future *p_dst, cc_future **pp_src, size_t n, cc_continuation *p_conts) {
+    return cc__future_when(p_dst, pp_src, n, p_conts, 0);
+}
+
+/* body of every thread taking part in a "cc_parallel_for", claims work until none is left */
+static inline void cc__parallel_for_part(void *arg) {
+    cc__parallel_for *p_loop = (cc__parallel_for *)arg;
+    uint64_t len = p_loop->end - p_loop->begin, first, last, chunk;
+    uint32_t part;
+
+    switch (p_loop->schedule) {
+    case CC_PARALLEL_STATIC:
+        while ((part = cc_atomic_fetch_add_u32(&p_loop->next_part, 1, CC_MO_RELAXED)) < p_loop->n_parts) {
+            /* the first "len % n_parts" blocks get one more iteration */
+            first = p_loop->begin + (len / p_loop->n_parts) * part + (part < len % p_loop->n_parts ? part : len % p_loop->n_parts);
+            last = first + len / p_loop->n_parts + (part < len % p_loop->n_parts ? 1 : 0);
+            if (first < last) p_loop->body((size_t)first, (size_t)last, p_loop->arg);
+        }
+        break;
+    case CC_PARALLEL_DYNAMIC:
+        /* claimed with a cas that stops at "end": a fetch_add past it wraps around when "end" is close to SIZE_MAX */
+        first = cc_atomic_load_u64(&p_loop->next, CC_MO_RELAXED);
+        while (first < p_loop->end) {
+            last = (p_loop->end - first > p_loop->grain) ? first + p_loop->grain : p_loop->end;
+            if (cc_atomic_cas_u64(&p_loop->next, &first, last, CC_MO_RELAXED, CC_MO_RELAXED)) {
+                p_loop->body((size_t)first, (size_t)last, p_loop->arg);
+                first = cc_atomic_load_u64(&p_loop->next, CC_MO_RELAXED);
+            }
+        }
+        break;
+    case CC_PARALLEL_GUIDED:
+        first = cc_atomic_load_u64(&p_loop->next, CC_MO_RELAXED);
+        while (first < p_loop->end) {
+            chunk = (p_loop->end - first) / (2 * (uint64_t)p_loop->n_parts);
+            if (chunk < p_loop->grain) chunk = p_loop->grain;
+            last = (p_loop->end - first > chunk) ? first + chunk : p_loop->end;
+            if (cc_atomic_cas_u64(&p_loop->next, &first, last, CC_MO_RELAXED, CC_MO_RELAXED)) {
+                p_loop->body((size_t)first, (size_t)last, p_loop->arg);
+                first = cc_atomic_load_u64(&p_loop->next, CC_MO_RELAXED);
+            }
+        }
+        break;
+    }
+}
+
+/*
+    Runs iterations from "*p_begin" onwards in doubling batches until their cost can be measured,
+    advances "*p_begin" past them and returns the grain that makes a chunk last about CC_PARALLEL_CHUNK_NS.
+*/
+static inline size_t cc__parallel_for_probe(size_t *p_begin, size_t end, uint32_t n_parts, void (*body)(size_t begin, size_t end, void *arg), void *arg) {
+    size_t begin = *p_begin, limit = (end - begin) / (8 * (size_t)n_parts), batch = 1, done = 0;
+    uint64_t start, elapsed = 0;
+
+    while (begin < end && done <= limit && elapsed < CC_PARALLEL_CHUNK_NS / 4) {
+        if (batch > end - begin) batch = end - begin;
+        start = cc__time_now_ns();
+        body(begin, begin + batch, arg);
+        elapsed += cc__time_now_ns() - start;
+        begin += batch;
+        done += batch;
+        batch *= 2;
+    }
+    *p_begin = begin;
+    if (0 == elapsed) elapsed = 1;
+    if ((uint64_t)done * CC_PARALLEL_CHUNK_NS / elapsed > SIZE_MAX) return SIZE_MAX;
+    return (size_t)((uint64_t)done * CC_PARALLEL_CHUNK_NS / elapsed) + 1;
+}
+
+/*
+    Calls "body(first, last, arg)" over disjoint sub-ranges covering [begin, end), on the workers of "p_pool"
+    and the calling thread, which helps until the whole range is done (it may be a pool task itself).
+    "grain" is the minimum chunk size (0: 1), ignored by CC_PARALLEL_AUTO.
+*/
+static inline int cc_parallel_for(cc_pool *p_pool, size_t begin, size_t end, int schedule, size_t grain, void (*body)(size_t begin, size_t end, void *arg), void *arg) {
+    cc__parallel_for loop;
+    cc_task_group group;
+    uint64_t n_chunks;
+    uint32_t n_parts, i;
+
+    if (!p_pool || !body || begin > end || schedule < CC_PARALLEL_STATIC || schedule > CC_PARALLEL_AUTO) return -1;
+    if (begin == end) return 0;
+    if (0 == grain) grain = 1;
+    n_parts = p_pool->n_workers + (cc__pool_current(p_pool) ? 0 : 1);
+
+    if (CC_PARALLEL_AUTO == schedule) {
+        grain = cc__parallel_for_probe(&begin, end, n_parts, body, arg);
+        schedule = CC_PARALLEL_DYNAMIC;
+        if (begin == end) return 0;
+    }
+    n_chunks = (end - begin) / grain + ((end - begin) % grain ? 1 : 0);
+    if (n_chunks < n_parts) n_parts = (uint32_t)n_chunks;
+    if (n_parts <= 1) {
+        body(begin, end, arg);
+        return 0;
+    }
+
+    loop.body = body;
+    loop.arg = arg;
+    loop.schedule = schedule;
+    loop.n_parts = n_parts;
+    loop.next_part = 0;
+    loop.begin = begin;
+    loop.end = end;
+    loop.grain = grain;
+    loop.next = begin;
+    cc_task_group_init(&group, p_pool);
+    /* a failed submit only means fewer helpers, the parts claim work instead of owning it */
+    for (i = 1; i < n_parts; i++) {
+        if (0 != cc_task_group_run(&group, cc__parallel_for_part, &loop)) break;
+    }
+    cc__parallel_for_part(&loop);
+    return cc_task_group_wait(&group);
+}
+
+/* sets up "n" items in blocks of at least "grain", returns the number of blocks (0 if the partials can't be allocated) */
+static inline size_t cc__parallel_blocks_init(cc__parallel_blocks *p_blocks, cc_pool *p_pool, size_t n, size_t grain, size_t size) {
+    size_t n_blocks = ((size_t)p_pool->n_workers + (cc__pool_current(p_pool) ? 0 : 1)) * CC_PARALLEL_BLOCKS;
+
+    p_blocks->block_len = n / n_blocks + (n % n_blocks ? 1 : 0);
+    if (p_blocks->block_len < grain) p_blocks->block_len = grain;
+    n_blocks = n / p_blocks->block_len + (n % p_blocks->block_len ? 1 : 0);
+    p_blocks->size = size;
+    p_blocks->stride = (2 * size + CC_CACHE_LINE_SIZE - 1) / CC_CACHE_LINE_SIZE * CC_CACHE_LINE_SIZE;
+    p_blocks->p_partials = (unsigned char *)cc__aligned_alloc(n_blocks * p_blocks->stride);
+    return p_blocks->p_partials ? n_blocks : 0;
+}
+
+/* reduce: every block folds its range into its partial with "map" */
+static inline void cc__parallel_reduce_blocks(size_t first, size_t last, void *arg) {
+    cc__parallel_blocks *p_blocks = (cc__parallel_blocks *)arg;
+    size_t b, lo, hi;
+
+    for (b = first; b < last; b++) {
+        void *p_acc = p_blocks->p_partials + b * p_blocks->stride;
+        lo = p_blocks->begin + b * p_blocks->block_len;
+        hi = (p_blocks->end - lo > p_blocks->block_len) ? lo + p_blocks->block_len : p_blocks->end;
+        memcpy(p_acc, p_blocks->p_identity, p_blocks->size);
+        p_blocks->map(lo, hi, p_acc, p_blocks->arg);
+    }
+}
+
+/*
+    Reduces [begin, end) with "map(first, last, p_acc, arg)", which folds a sub-range into an accumulator
+    starting at "*p_identity", and "combine(p_acc, p_other, arg)", which folds a partial into another.
+    Partials are combined in range order, so "combine" has to be associative but not commutative.
+    "size" is the size of the accumulator, the result is stored in "p_result".
+*/
+static inline int cc_parallel_reduce(cc_pool *p_pool, size_t begin, size_t end, size_t grain, void *p_result, size_t size, const void *p_identity, void (*map)(size_t first, size_t last, void *p_acc, void *arg), void (*combine)(void *p_acc, const void *p_other, void *arg), void *arg) {
+    cc__parallel_blocks blocks;
+    size_t n_blocks, b;
+    int ret;
+
+    if (!p_pool || !p_result || !size || !p_identity || !map || !combine || begin > end) return -1;
+    if (begin == end) {
+        memmove(p_result, p_identity, size);
+        return 0;
+    }
+    if (!(n_blocks = cc__parallel_blocks_init(&blocks, p_pool, end - begin, grain ? grain : 1, size))) return -2;
+    blocks.begin = begin;
+    blocks.end = end;
+    blocks.p_identity = p_identity;
+    blocks.map = map;
+    blocks.combine = combine;
+    blocks.arg = arg;
+
+    ret = cc_parallel_for(p_pool, 0, n_blocks, CC_PARALLEL_DYNAMIC, 1, cc__parallel_reduce_blocks, &blocks);
+    if (0 == ret) {
+        memmove(p_result, p_identity, size);
+        for (b = 0; b < n_blocks; b++) combine(p_result, blocks.p_partials + b * blocks.stride, arg);
+    }
+    cc__aligned_free(blocks.p_partials);
+    return ret;
+}
+
+/* scan, first pass: the total of every block */
+static inline void cc__parallel_scan_reduce(size_t first, size_t last, void *arg) {
+    cc__parallel_blocks *p_blocks = (cc__parallel_blocks *)arg;
+    size_t b, i, hi;
+
+    for (b = first; b < last; b++) {
+        void *p_acc = p_blocks->p_partials + b * p_blocks->stride;
+        i = b * p_blocks->block_len;
+        hi = (p_blocks->end - i > p_blocks->block_len) ? i + p_blocks->block_len : p_blocks->end;
+        memcpy(p_acc, p_blocks->p_identity, p_blocks->size);
+        for (; i < hi; i++) p_blocks->combine(p_acc, p_blocks->p_in + i * p_blocks->size, p_blocks->arg);
+    }
+}
+
+/* scan, second pass: every block scans its items starting from the total of the blocks before it */
+static inline void cc__parallel_scan_apply(size_t first, size_t last, void *arg) {
+    cc__parallel_blocks *p_blocks = (cc__parallel_blocks *)arg;
+    size_t b, i, hi, size = p_blocks->size;
+
+    for (b = first; b < last; b++) {
+        unsigned char *p_acc = p_blocks->p_partials + b * p_blocks->stride;
+        unsigned char *p_item = p_acc + size;  /* copy of the input, "p_in" may be "p_out" */
+        i = b * p_blocks->block_len;
+        hi = (p_blocks->end - i > p_blocks->block_len) ? i + p_blocks->block_len : p_blocks->end;
+        for (; i < hi; i++) {
+            memcpy(p_item, p_blocks->p_in + i * size, size);
+            if (CC_SCAN_EXCLUSIVE == p_blocks->mode) memcpy(p_blocks->p_out + i * size, p_acc, size);
+            p_blocks->combine(p_acc, p_item, p_blocks->arg);
+            if (CC_SCAN_INCLUSIVE == p_blocks->mode) memcpy(p_blocks->p_out + i * size, p_acc, size);
+        }
+    }
+}
+
+/*
+    Prefix "sum" of the "n" items of "size" bytes at "p_in" into "p_out" (may be the same array), with the
+    associative "combine(p_acc, p_item, arg)" folding an item into an accumulator of the same type.
+    Two passes over blocks of at least "grain" items: block totals, then every block scans from its offset.
+*/
+static inline int cc_parallel_scan(cc_pool *p_pool, const void *p_in, void *p_out, size_t n, size_t size, size_t grain, const void *p_identity, void (*combine)(void *p_acc, const void *p_item, void *arg), int mode, void *arg) {
+    cc__parallel_blocks blocks;
+    unsigned char *p_total;
+    size_t n_blocks, b;
+    int ret;
+
+    if (!p_pool || !p_in || !p_out || !size || !p_identity || !combine) return -1;
+    if (CC_SCAN_INCLUSIVE != mode && CC_SCAN_EXCLUSIVE != mode) return -1;
+    if (0 == n) return 0;
+    if (!(n_blocks = cc__parallel_blocks_init(&blocks, p_pool, n, grain ? grain : 1, size))) return -2;
+    blocks.begin = 0;
+    blocks.end = n;
+    blocks.p_identity = p_identity;
+    blocks.p_in = (const unsigned char *)p_in;
+    blocks.p_out = (unsigned char *)p_out;
+    blocks.combine = combine;
+    blocks.arg = arg;
+    blocks.mode = mode;
+
+    /* the last block's total is never needed */
+    ret = cc_parallel_for(p_pool, 0, n_blocks - 1, CC_PARALLEL_DYNAMIC, 1, cc__parallel_scan_reduce, &blocks);
+    if (0 == ret) {
+        /* block totals -> block offsets, the last block's scratch holds the running total */
+        p_total = blocks.p_partials + (n_blocks - 1) * blocks.stride + size;
+        memcpy(p_total, p_identity, size);
+        for (b = 0; b < n_blocks - 1; b++) {
+            unsigned char *p_partial = blocks.p_partials + b * blocks.stride;
+            memcpy(p_partial + size, p_partial, size);
+            memcpy(p_partial, p_total, size);
+            combine(p_total, p_partial + size, arg);
+        }
+        memcpy(p_total - size, p_total, size);
+        ret = cc_parallel_for(p_pool, 0, n_blocks, CC_PARALLEL_DYNAMIC, 1, cc__parallel_scan_apply, &blocks);
+    }
+    cc__aligned_free(blocks.p_partials);
+    return ret;
+}
+
+/* sample sort: bucket of an item, the number of splitters not greater than it */
+static inline size_t cc__sample_sort_bucket(cc__parallel_sort *p_sort, const void *p_item) {
+    size_t lo = 0, hi = p_sort->n_buckets - 1, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (p_sort->compare(p_item, p_sort->p_splitters + mid * p_sort->size) < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+static inline void cc__sample_sort_count(size_t first, size_t last, void *arg) {
+    cc__parallel_sort *p_sort = (cc__parallel_sort *)arg;
+    size_t b, i, hi;
+
+    for (b = first; b < last; b++) {
+        size_t *p_row = p_sort->p_counts + b * p_sort->n_buckets;
+        i = b * p_sort->block_len;
+        hi = (p_sort->n - i > p_sort->block_len) ? i + p_sort->block_len : p_sort->n;
+        memset(p_row, 0, p_sort->n_buckets * sizeof(size_t));
+        for (; i < hi; i++) p_row[cc__sample_sort_bucket(p_sort, p_sort->p_src + i * p_sort->size)]++;
+    }
+}
+
+static inline void cc__sample_sort_scatter(size_t first, size_t last, void *arg) {
+    cc__parallel_sort *p_sort = (cc__parallel_sort *)arg;
+    size_t b, i, hi;
+
+    for (b = first; b < last; b++) {
+        size_t *p_row = p_sort->p_counts + b * p_sort->n_buckets;
+        i = b * p_sort->block_len;
+        hi = (p_sort->n - i > p_sort->block_len) ? i + p_sort->block_len : p_sort->n;
+        for (; i < hi; i++) {
+            const unsigned char *p_item = p_sort->p_src + i * p_sort->size;
+            memcpy(p_sort->p_dst + p_row[cc__sample_sort_bucket(p_sort, p_item)]++ * p_sort->size, p_item, p_sort->size);
+        }
+    }
+}
+
+/* sorts every bucket on its own and moves it back to its final place in the input */
+static inline void cc__sample_sort_buckets(size_t first, size_t last, void *arg) {
+    cc__parallel_sort *p_sort = (cc__parallel_sort *)arg;
+    size_t j, start, len;
+
+    for (j = first; j < last; j++) {
+        start = p_sort->p_bucket_start[j];
+        len = p_sort->p_bucket_start[j + 1] - start;
+        qsort(p_sort->p_dst + start * p_sort->size, len, p_sort->size, p_sort->compare);
+        memcpy(p_sort->p_src + start * p_sort->size, p_sort->p_dst + start * p_sort->size, len * p_sort->size);
+    }
+}
+
+/* turns the per block counts into destination slots, buckets (digits) first so the output stays stable */
+static inline void cc__parallel_sort_offsets(cc__parallel_sort *p_sort, size_t n_blocks) {
+    size_t b, j, count, running = 0;
+
+    for (j = 0; j < p_sort->n_buckets; j++) {
+        if (p_sort->p_bucket_start) p_sort->p_bucket_start[j] = running;
+        for (b = 0; b < n_blocks; b++) {
+            count = p_sort->p_counts[b * p_sort->n_buckets + j];
+            p_sort->p_counts[b * p_sort->n_buckets + j] = running;
+            running += count;
+        }
+    }
+    if (p_sort->p_bucket_start) p_sort->p_bucket_start[p_sort->n_buckets] = running;
+}
+
+/* splits "n" items into one block per bucket, at least "min_len" items long, returns the number of blocks */
+static inline size_t cc__parallel_sort_blocks(cc__parallel_sort *p_sort, size_t n_blocks, size_t min_len) {
+    p_sort->block_len = p_sort->n / n_blocks + (p_sort->n % n_blocks ? 1 : 0);
+    if (p_sort->block_len < min_len) p_sort->block_len = min_len;
+    return p_sort->n / p_sort->block_len + (p_sort->n % p_sort->block_len ? 1 : 0);
+}
+
+/*
+    Sample sort with a qsort "compare": splitters picked from a sorted oversample route every item to a bucket,
+    blocks count then scatter their items into a scratch copy at precomputed slots (no locks), and the buckets
+    are sorted independently. Not stable. Small inputs fall back to qsort.
+*/
+static inline int cc_parallel_sort(cc_pool *p_pool, void *base, size_t n, size_t size, int (*compare)(const void *p_a, const void *p_b)) {
+    cc__parallel_sort sort;
+    unsigned char *p_samples;
+    size_t n_threads, n_samples, n_blocks, i, j;
+    uint32_t rng = 2463534242U;
+    int ret;
+
+    if (!p_pool || (!base && n) || !size || !compare) return -1;
+    n_threads = (size_t)p_pool->n_workers + (cc__pool_current(p_pool) ? 0 : 1);
+    if (n <= CC_SORT_SEQUENTIAL_MAX || 1 == n_threads) {
+        if (n > 1) qsort(base, n, size, compare);
+        return 0;
+    }
+
+    sort.p_src = (unsigned char *)base;
+    sort.n = n;
+    sort.size = size;
+    sort.compare = compare;
+    sort.n_buckets = n_threads * CC_PARALLEL_BLOCKS;
+    if (sort.n_buckets > n / (4 * CC_SORT_OVERSAMPLE)) sort.n_buckets = n / (4 * CC_SORT_OVERSAMPLE);
+    n_blocks = cc__parallel_sort_blocks(&sort, sort.n_buckets, 1);
+    n_samples = sort.n_buckets * CC_SORT_OVERSAMPLE;
+    sort.p_dst = (unsigned char *)malloc(n * size);
+    sort.p_counts = (size_t *)malloc(n_blocks * sort.n_buckets * sizeof(size_t));
+    sort.p_bucket_start = (size_t *)malloc((sort.n_buckets + 1) * sizeof(size_t));
+    p_samples = (unsigned char *)malloc(n_samples * size);
+    sort.p_splitters = (unsigned char *)malloc((sort.n_buckets - 1) * size);
+    ret = -2;
+
+    if (sort.p_dst && sort.p_counts && sort.p_bucket_start && p_samples && sort.p_splitters) {
+        /* one sample from every stride of the input, at a pseudo random position inside it */
+        for (i = 0; i < n_samples; i++) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            memcpy(p_samples + i * size, sort.p_src + (i * (n / n_samples) + rng % (n / n_samples)) * size, size);
+        }
+        qsort(p_samples, n_samples, size, compare);
+        for (j = 1; j < sort.n_buckets; j++)
+            memcpy(sort.p_splitters + (j - 1) * size, p_samples + j * CC_SORT_OVERSAMPLE * size, size);
+
+        ret = cc_parallel_for(p_pool, 0, n_blocks, CC_PARALLEL_DYNAMIC, 1, cc__sample_sort_count, &sort);
+        if (0 == ret) {
+            cc__parallel_sort_offsets(&sort, n_blocks);
+            ret = cc_parallel_for(p_pool, 0, n_blocks, CC_PARALLEL_DYNAMIC, 1, cc__sample_sort_scatter, &sort);
+        }
+        if (0 == ret) ret = cc_parallel_for(p_pool, 0, sort.n_buckets, CC_PARALLEL_DYNAMIC, 1, cc__sample_sort_buckets, &sort);
+    }
+    free(sort.p_dst);
+    free(sort.p_counts);
+    free(sort.p_bucket_start);
+    free(p_samples);
+    free(sort.p_splitters);
+    return ret;
+}
+
+static inline void cc__radix_sort_count(size_t first, size_t last, void *arg) {
+    cc__parallel_sort *p_sort = (cc__parallel_sort *)arg;
+    size_t b, i, hi;
+
+    for (b = first; b < last; b++) {
+        size_t *p_row = p_sort->p_counts + b * CC__RADIX_DIGITS;
+        i = b * p_sort->block_len;
+        hi = (p_sort->n - i > p_sort->block_len) ? i + p_sort->block_len : p_sort->n;
+        memset(p_row, 0, CC__RADIX_DIGITS * sizeof(size_t));
+        for (; i < hi; i++) p_row[(p_sort->key(p_sort->p_src + i * p_sort->size) >> p_sort->shift) & (CC__RADIX_DIGITS - 1)]++;
+    }
+}
+
+static inline void cc__radix_sort_scatter(size_t first, size_t last, void *arg) {
+    cc__parallel_sort *p_sort = (cc__parallel_sort *)arg;
+    size_t b, i, hi;
+
+    for (b = first; b < last; b++) {
+        size_t *p_row = p_sort->p_counts + b * CC__RADIX_DIGITS;
+        i = b * p_sort->block_len;
+        hi = (p_sort->n - i > p_sort->block_len) ? i + p_sort->block_len : p_sort->n;
+        for (; i < hi; i++) {
+            const unsigned char *p_item = p_sort->p_src + i * p_sort->size;
+            size_t digit = (size_t)(p_sort->key(p_item) >> p_sort->shift) & (CC__RADIX_DIGITS - 1);
+            memcpy(p_sort->p_dst + p_row[digit]++ * p_sort->size, p_item, p_sort->size);
+        }
+    }
+}
+
+static inline void cc__radix_sort_copy(size_t first, size_t last, void *arg) {
+    cc__parallel_sort *p_sort = (cc__parallel_sort *)arg;
+    memcpy(p_sort->p_dst + first * p_sort->size, p_sort->p_src + first * p_sort->size, (last - first) * p_sort->size);
+}
+
+static inline void cc__radix_sort_key_bits(size_t first, size_t last, void *p_acc, void *arg) {
+    cc__parallel_sort *p_sort = (cc__parallel_sort *)arg;
+    uint64_t bits = 0;
+    size_t i;
+
+    for (i = first; i < last; i++) bits |= p_sort->key(p_sort->p_src + i * p_sort->size);
+    *(uint64_t *)p_acc |= bits;
+}
+
+static inline void cc__radix_sort_or(void *p_acc, const void *p_other, void *arg) {
+    (void)arg;
+    *(uint64_t *)p_acc |= *(const uint64_t *)p_other;
+}
+
+/*
+    Stable LSD radix sort of "n" items of "size" bytes by the unsigned 64 bit "key" of every item, one byte
+    per pass. Passes stop at the highest set bit of any key and passes where every key has the same digit
+    are skipped. Every pass counts digits per block, then blocks scatter at precomputed slots (no locks).
+*/
+static inline int cc_parallel_radix_sort(cc_pool *p_pool, void *base, size_t n, size_t size, uint64_t (*key)(const void *p_item)) {
+    cc__parallel_sort sort;
+    unsigned char *p_scratch, *p_swap;
+    size_t n_blocks, b, d;
+    uint64_t bits = 0, zero = 0;
+    int ret, skip;
+
+    if (!p_pool || (!base && n) || !size || !key) return -1;
+    if (n < 2) return 0;
+    sort.p_src = (unsigned char *)base;
+    sort.n = n;
+    sort.size = size;
+    sort.key = key;
+    sort.n_buckets = CC__RADIX_DIGITS;
+    sort.p_bucket_start = NULL;
+    n_blocks = cc__parallel_sort_blocks(&sort, ((size_t)p_pool->n_workers + (cc__pool_current(p_pool) ? 0 : 1)) * CC_PARALLEL_BLOCKS, CC_SORT_SEQUENTIAL_MAX / 4);
+    p_scratch = (unsigned char *)malloc(n * size);
+    sort.p_counts = (size_t *)cc__aligned_alloc(n_blocks * CC__RADIX_DIGITS * sizeof(size_t));
+    sort.p_dst = p_scratch;
+    ret = -2;
+
+    if (p_scratch && sort.p_counts)
+        ret = cc_parallel_reduce(p_pool, 0, n, sort.block_len, &bits, sizeof(bits), &zero, cc__radix_sort_key_bits, cc__radix_sort_or, &sort);
+    for (sort.shift = 0; 0 == ret && sort.shift < 64 && (bits >> sort.shift); sort.shift += 8) {
+        if (0 != (ret = cc_parallel_for(p_pool, 0, n_blocks, CC_PARALLEL_DYNAMIC, 1, cc__radix_sort_count, &sort))) break;
+        /* a digit shared by every key leaves the order unchanged */
+        for (d = 0, skip = 0; d < CC__RADIX_DIGITS && !skip; d++) {
+            size_t total = 0;
+            for (b = 0; b < n_blocks; b++) total += sort.p_counts[b * CC__RADIX_DIGITS + d];
+            skip = (total == n);
+        }
+        if (skip) continue;
+        cc__parallel_sort_offsets(&sort, n_blocks);
+        if (0 != (ret = cc_parallel_for(p_pool, 0, n_blocks, CC_PARALLEL_DYNAMIC, 1, cc__radix_sort_scatter, &sort))) break;
+        p_swap = sort.p_src;
+        sort.p_src = sort.p_dst;
+        sort.p_dst = p_swap;
+    }
+    if (0 == ret && sort.p_src != (unsigned char *)base) {
+        sort.p_dst = (unsigned char *)base;
+        ret = cc_parallel_for(p_pool, 0, n, CC_PARALLEL_STATIC, sort.block_len, cc__radix_sort_copy, &sort);
+    }
+    free(p_scratch);
+    cc__aligned_free(sort.p_counts);
+    return ret;
+}
+
+/* TLS slot holding the "cc_prio_pool" the calling thread works for, if any */
+CC__SHARED cc_tls_key cc__prio_pool_key = 0;
+CC__SHARED cc_once cc__prio_pool_key_once = CC_ONCE_INIT;
+
+static inline void cc__prio_pool_key_create(void) {
+    cc_tls_key_create(&cc__prio_pool_key);
+}
+
+/*
+    Unlinks the next task, mutex held: the head of the highest band, where the head of a lower band counts one
+    band higher per "aging_ns" it has waited. Heads are the oldest tasks of their band, so checking them is enough.
+*/
+static inline cc__prio_task *cc__prio_pool_pop(cc_prio_pool *p_pool) {
+    cc__prio_band *p_band;
+    cc__prio_task *p_task;
+    uint64_t now = 0, level, best_level = 0, best_queued = 0, age;
+    int b, best = -1;
+
+    for (b = 0; b < CC_PRIO_BANDS; b++) {
+        if (!(p_task = p_pool->bands[b].p_head)) continue;
+        level = (uint64_t)b;
+        if (p_pool->aging_ns && b > 0) {
+            if (0 == now) now = cc__time_now_ns();
+            age = (now - p_task->queued_ns) / p_pool->aging_ns;
+            level = (age >= level) ? 0 : level - age;
+        }
+        /* on a tie the older task wins, an aged task isn't held back by a stream of fresh urgent ones */
+        if (best < 0 || level < best_level || (level == best_level && p_task->queued_ns < best_queued)) {
+            best = b;
+            best_level = level;
+            best_queued = p_task->queued_ns;
+        }
+    }
+    if (best < 0) return NULL;
+
+    p_band = &p_pool->bands[best];
+    p_task = p_band->p_head;
+    if (!(p_band->p_head = p_task->p_next)) p_band->p_tail = NULL;
+    return p_task;
+}
+
+static CC_TH_FUNC_RET cc__prio_pool_worker_main(void *arg) {
+    cc_prio_pool *p_pool = (cc_prio_pool *)arg;
+    cc__prio_task *p_task;
+    void (*func)(void *arg);
+    void *task_arg;
+
+    cc_call_once(&cc__prio_pool_key_once, cc__prio_pool_key_create);
+    cc_tls_set(cc__prio_pool_key, p_pool);
+    cc_mtx_lock(&p_pool->mtx);
+    for (;;) {
+        /* the band is picked again at every task boundary, so urgent work overtakes queued batch work */
+        while (!(p_task = cc__prio_pool_pop(p_pool)) && !p_pool->stop) cc_cond_wait(&p_pool->work_cond, &p_pool->mtx);
+        if (!p_task) break;
+        func = p_task->func;
+        task_arg = p_task->arg;
+        p_task->p_next = p_pool->p_free;
+        p_pool->p_free = p_task;
+        p_pool->n_free++;
+        cc_mtx_unlock(&p_pool->mtx);
+
+        func(task_arg);
+
+        cc_mtx_lock(&p_pool->mtx);
+        if (0 == --p_pool->pending) cc_cond_broadcast(&p_pool->idle_cond);
+    }
+    cc_mtx_unlock(&p_pool->mtx);
+    cc_tls_set(cc__prio_pool_key, NULL);
+    CC_TH_RETURN(0);
+}
+
+static inline void cc__prio_pool_stop(cc_prio_pool *p_pool, uint32_t n_started) {
+    uint32_t i;
+
+    cc_mtx_lock(&p_pool->mtx);
+    p_pool->stop = 1;
+    cc_cond_broadcast(&p_pool->work_cond);
+    cc_mtx_unlock(&p_pool->mtx);
+    for (i = 0; i < n_started; i++) cc_th_join(p_pool->p_threads[i], NULL);
+}
+
+/*
+    Pool of "n_workers" threads (0: one per online cpu) running tasks by priority band, FIFO within a band.
+    Tasks waiting longer than "aging_ms" move up one band per period so lower bands can't starve, 0 disables aging.
+*/
+static inline int cc_prio_pool_init(cc_prio_pool *p_pool, uint32_t n_workers, uint32_t aging_ms) {
+    uint32_t i;
+    int b;
+
+    if (!p_pool) return -1;
+    if (0 == n_workers) n_workers = cc__cpu_count();
+
+    cc_mtx_init(&p_pool->mtx);
+    cc_cond_init(&p_pool->work_cond);
+    cc_cond_init(&p_pool->idle_cond);
+    for (b = 0; b < CC_PRIO_BANDS; b++) {
+        p_pool->bands[b].p_pool = p_pool;
+        p_pool->bands[b].p_head = NULL;
+        p_pool->bands[b].p_tail = NULL;
+    }
+    p_pool->p_free = NULL;
+    p_pool->n_free = 0;
+    p_pool->n_workers = n_workers;
+    p_pool->pending = 0;
+    p_pool->stop = 0;
+    p_pool->aging_ns = (uint64_t)aging_ms * 1000000U;
+    p_pool->p_threads = (cc_th *)malloc(n_workers * sizeof(cc_th));
+    if (!p_pool->p_threads) return -2;
+
+    for (i = 0; i < n_workers; i++) {
+        if (0 != cc_th_create(&p_pool->p_threads[i], NULL, cc__prio_pool_worker_main, p_pool)) {
+            cc__prio_pool_stop(p_pool, i);
+            free(p_pool->p_threads);
+            p_pool->p_threads = NULL;
+            return -2;
+        }
+    }
+    return 0;
+}
+
+/* queues "func(arg)" at the end of "band", returns -1 once the pool is shut down */
+static inline int cc_prio_pool_submit(cc_prio_pool *p_pool, int band, void (*func)(void *arg), void *arg) {
+    cc__prio_band *p_band;
+    cc__prio_task *p_task;
+
+    if (!p_pool || !func || band < 0 || band >= CC_PRIO_BANDS) return -1;
+    cc_mtx_lock(&p_pool->mtx);
+    if (p_pool->stop) {
+        cc_mtx_unlock(&p_pool->mtx);
+        return -1;
+    }
+    if ((p_task = p_pool->p_free)) {
+        p_pool->p_free = p_task->p_next;
+        p_pool->n_free--;
+    }
+    else if (!(p_task = (cc__prio_task *)malloc(sizeof(cc__prio_task)))) {
+        cc_mtx_unlock(&p_pool->mtx);
+        return -2;
+    }
+    p_task->func = func;
+    p_task->arg = arg;
+    p_task->queued_ns = p_pool->aging_ns ? cc__time_now_ns() : 0;
+    p_task->p_next = NULL;
+
+    p_band = &p_pool->bands[band];
+    if (p_band->p_tail) p_band->p_tail->p_next = p_task;
+    else p_band->p_head = p_task;
+    p_band->p_tail = p_task;
+    p_pool->pending++;
+    cc_cond_signal(&p_pool->work_cond);
+    cc_mtx_unlock(&p_pool->mtx);
+    return 0;
+}
+
+/* NOTE: waits for every task submitted so far and the ones they submit, a task can't wait for its own pool */
+static inline int cc_prio_pool_wait(cc_prio_pool *p_pool) {
+    if (!p_pool) return -1;
+    cc_call_once(&cc__prio_pool_key_once, cc__prio_pool_key_create);
+    if (cc_tls_get(cc__prio_pool_key) == (void *)p_pool) return EDEADLK;
+    cc_mtx_lock(&p_pool->mtx);
+    while (0 != p_pool->pending) cc_cond_wait(&p_pool->idle_cond, &p_pool->mtx);
+    cc_mtx_unlock(&p_pool->mtx);
+    return 0;
+}
+
+/* drains the queued tasks, then stops and joins the workers */
+static inline int cc_prio_pool_shutdown(cc_prio_pool *p_pool) {
+    int err, stopped;
+
+    if (!p_pool) return -1;
+    cc_mtx_lock(&p_pool->mtx);
+    stopped = (0 != p_pool->stop);
+    cc_mtx_unlock(&p_pool->mtx);
+    if (!p_pool->p_threads || stopped) return 0;
+    if (0 != (err = cc_prio_pool_wait(p_pool))) return err;
+    cc__prio_pool_stop(p_pool, p_pool->n_workers);
+    return 0;
+}
+
+static inline int cc_prio_pool_destroy(cc_prio_pool *p_pool) {
+    cc__prio_task *p_task;
+    int err;
+
+    if (!p_pool) return -1;
+    if (0 != (err = cc_prio_pool_shutdown(p_pool))) return err;
+    while ((p_task = p_pool->p_free)) {
+        p_pool->p_free = p_task->p_next;
+        free(p_task);
+    }
+    p_pool->n_free = 0;
+    free(p_pool->p_threads);
+    p_pool->p_threads = NULL;
+    cc_cond_destroy(&p_pool->work_cond);
+    cc_cond_destroy(&p_pool->idle_cond);
+    cc_mtx_destroy(&p_pool->mtx);
+    return 0;
+}
+
+static inline int cc__prio_pool_executor_submit(void *ctx, void (*func)(void *arg), void *arg) {
+    cc__prio_band *p_band = (cc__prio_band *)ctx;
+    return cc_prio_pool_submit(p_band->p_pool, (int)(p_band - p_band->p_pool->bands), func, arg);
+}
+
+/* executor submitting into one band, e.g. to run future continuations at a given priority */
+static inline cc_executor cc_prio_pool_executor(cc_prio_pool *p_pool, int band) {
+    cc_executor exec;
+    exec.submit = cc__prio_pool_executor_submit;
+    exec.ctx = &p_pool->bands[band < 0 ? 0 : (band >= CC_PRIO_BANDS ? CC_PRIO_LOWEST : band)];
+    return exec;
+}
+
+#define CC__TIMER_IDLE      0U
+#define CC__TIMER_PENDING   1U
+#define CC__TIMER_NO_SLOT   0xFFFFFFFFU
+
+static inline uint64_t cc__timer_clock_tick(cc_timer_wheel *p_wheel) {
+    return (cc__time_now_ns() - p_wheel->start_ns) / p_wheel->tick_ns;
+}
+
+/* mutex held for every "cc__timer_*" helper below */
+static inline void cc__timer_link(cc_timer **pp_head, cc_timer *p_timer) {
+    p_timer->p_next = *pp_head;
+    p_timer->pp_prev = pp_head;
+    if (*pp_head) (*pp_head)->pp_prev = &p_timer->p_next;
+    *pp_head = p_timer;
+}
+
+static inline void cc__timer_unlink(cc_timer_wheel *p_wheel, cc_timer *p_timer) {
+    uint32_t level = p_timer->slot >> CC__TIMER_SLOT_BITS, index = p_timer->slot & (CC__TIMER_SLOTS - 1);
+
+    *p_timer->pp_prev = p_timer->p_next;
+    if (p_timer->p_next) p_timer->p_next->pp_prev = p_timer->pp_prev;
+    if (CC__TIMER_NO_SLOT != p_timer->slot && !p_wheel->slots[level][index])
+        p_wheel->occupied[level] &= ~(1ULL << index);
+    p_timer->p_next = NULL;
+    p_timer->pp_prev = NULL;
+}
+
+/*
+    O(1): the level is picked from the distance to the expiry (a timer due within 64 ticks goes to level 0) and
+    the slot from the matching bits of the expiry, overdue timers expire on the next tick. Timers beyond the
+    last level park in its farthest slot and are placed again when it cascades.
+*/
+static inline void cc__timer_insert(cc_timer_wheel *p_wheel, cc_timer *p_timer) {
+    uint64_t expires = (p_timer->expires < p_wheel->now) ? p_wheel->now : p_timer->expires;
+    uint64_t delta = expires - p_wheel->now;
+    uint32_t level = 0, index;
+
+    while (level < CC_TIMER_LEVELS - 1 && delta >> (CC__TIMER_SLOT_BITS * (level + 1))) level++;
+    if (CC_TIMER_LEVELS * CC__TIMER_SLOT_BITS < 64 && delta >> (CC__TIMER_SLOT_BITS * CC_TIMER_LEVELS))
+        expires = p_wheel->now + (1ULL << (CC__TIMER_SLOT_BITS * CC_TIMER_LEVELS)) - 1;
+    index = (uint32_t)(expires >> (CC__TIMER_SLOT_BITS * level)) & (CC__TIMER_SLOTS - 1);
+
+    p_timer->slot = (level << CC__TIMER_SLOT_BITS) | index;
+    cc__timer_link(&p_wheel->slots[level][index], p_timer);
+    p_wheel->occupied[level] |= 1ULL << index;
+}
+
+/* "now" just reached a multiple of 64: moves the slots of the upper levels whose time has come down */
+static inline void cc__timer_cascade(cc_timer_wheel *p_wheel) {
+    cc_timer *p_list, *p_timer;
+    uint32_t level, index;
+
+    for (level = 1; level < CC_TIMER_LEVELS; level++) {
+        index = (uint32_t)(p_wheel->now >> (CC__TIMER_SLOT_BITS * level)) & (CC__TIMER_SLOTS - 1);
+        p_list = p_wheel->slots[level][index];
+        p_wheel->slots[level][index] = NULL;
+        p_wheel->occupied[level] &= ~(1ULL << index);
+        while ((p_timer = p_list)) {
+            p_list = p_timer->p_next;
+            cc__timer_insert(p_wheel, p_timer);
+        }
+        if (0 != index) break;
+    }
+}
+
+/*
+    Runs the timers moved to "p_expired", the mutex is released around every callback. A periodic timer is
+    rearmed before its callback and a one shot one goes idle, so the timer is never touched once the callback
+    started: it may free it.
+*/
+static inline void cc__timer_run_expired(cc_timer_wheel *p_wheel) {
+    cc_timer *p_timer;
+    void (*func)(void *arg);
+    void *arg;
+
+    while ((p_timer = p_wheel->p_expired)) {
+        cc__timer_unlink(p_wheel, p_timer);
+        if (p_timer->period) {
+            p_timer->expires += p_timer->period;
+            cc__timer_insert(p_wheel, p_timer);
+        }
+        else {
+            p_timer->state = CC__TIMER_IDLE;
+            p_wheel->n_pending--;
+        }
+        func = p_timer->func;
+        arg = p_timer->arg;
+        p_wheel->p_running = p_timer;
+        cc_mtx_unlock(&p_wheel->mtx);
+
+        func(arg);
+
+        cc_mtx_lock(&p_wheel->mtx);
+        p_wheel->p_running = NULL;
+        cc_cond_broadcast(&p_wheel->done_cond);
+    }
+}
+
+/* expires every tick before "target", skipping the rest of a level 0 rotation at once when it's empty */
+static inline void cc__timer_advance(cc_timer_wheel *p_wheel, uint64_t target) {
+    cc_timer *p_list, *p_timer;
+    uint32_t index;
+    uint64_t next;
+
+    while (p_wheel->now < target && !p_wheel->stop) {
+        index = (uint32_t)p_wheel->now & (CC__TIMER_SLOTS - 1);
+        if (0 == p_wheel->n_pending) {
+            p_wheel->now = target;
+            break;
+        }
+        if (0 == (p_wheel->occupied[0] >> index)) {
+            next = (p_wheel->now | (CC__TIMER_SLOTS - 1)) + 1;
+            if (next > target) {
+                p_wheel->now = target;
+                break;
+            }
+            p_wheel->now = next;
+            cc__timer_cascade(p_wheel);
+            continue;
+        }
+        p_list = p_wheel->slots[0][index];
+        p_wheel->slots[0][index] = NULL;
+        p_wheel->occupied[0] &= ~(1ULL << index);
+        while ((p_timer = p_list)) {
+            p_list = p_timer->p_next;
+            p_timer->slot = CC__TIMER_NO_SLOT;
+            cc__timer_link(&p_wheel->p_expired, p_timer);
+        }
+        /* moved on first, timers (re)scheduled by the callbacks never land in the slot being expired */
+        p_wheel->now++;
+        if (0 == (p_wheel->now & (CC__TIMER_SLOTS - 1))) cc__timer_cascade(p_wheel);
+        cc__timer_run_expired(p_wheel);
+    }
+}
+
+/* next tick worth waking up for: the next busy level 0 slot, or the next cascade */
+static inline uint64_t cc__timer_next_tick(cc_timer_wheel *p_wheel) {
+    uint64_t bits, tick = p_wheel->now;
+
+    if (0 == p_wheel->n_pending) return UINT64_MAX;
+    bits = p_wheel->occupied[0] >> (p_wheel->now & (CC__TIMER_SLOTS - 1));
+    if (0 == bits) return (p_wheel->now | (CC__TIMER_SLOTS - 1)) + 1;
+    for (; !(bits & 1); bits >>= 1) tick++;
+    return tick;
+}
+
+static CC_TH_FUNC_RET cc__timer_wheel_main(void *arg) {
+    cc_timer_wheel *p_wheel = (cc_timer_wheel *)arg;
+    struct timespec deadline;
+    uint64_t deadline_ns;
+
+    cc_mtx_lock(&p_wheel->mtx);
+    p_wheel->th_id = cc_th_self();
+    while (!p_wheel->stop) {
+        cc__timer_advance(p_wheel, cc__timer_clock_tick(p_wheel) + 1);
+        if (p_wheel->stop) break;
+        p_wheel->wake_tick = cc__timer_next_tick(p_wheel);
+        if (UINT64_MAX == p_wheel->wake_tick) cc_cond_wait(&p_wheel->cond, &p_wheel->mtx);
+        else {
+            deadline_ns = p_wheel->start_ns + p_wheel->wake_tick * p_wheel->tick_ns;
+            deadline.tv_sec = (time_t)(deadline_ns / 1000000000ULL);
+            deadline.tv_nsec = (long)(deadline_ns % 1000000000ULL);
+            cc_cond_timedwait(&p_wheel->cond, &p_wheel->mtx, &deadline);
+        }
+    }
+    p_wheel->wake_tick = 0;
+    cc_mtx_unlock(&p_wheel->mtx);
+    CC_TH_RETURN(0);
+}
+
+/* wheel advancing every "tick_ms" (0: CC_TIMER_TICK_MS) on its own service thread */
+static inline int cc_timer_wheel_init(cc_timer_wheel *p_wheel, uint32_t tick_ms) {
+    uint32_t level, index;
+
+    if (!p_wheel) return -1;
+    if (0 == tick_ms) tick_ms = CC_TIMER_TICK_MS;
+
+    cc_mtx_init(&p_wheel->mtx);
+    cc_cond_init(&p_wheel->cond);
+    cc_cond_init(&p_wheel->done_cond);
+    p_wheel->start_ns = cc__time_now_ns();
+    p_wheel->tick_ns = (uint64_t)tick_ms * 1000000U;
+    p_wheel->now = 0;
+    p_wheel->wake_tick = UINT64_MAX;
+    for (level = 0; level < CC_TIMER_LEVELS; level++) {
+        p_wheel->occupied[level] = 0;
+        for (index = 0; index < CC__TIMER_SLOTS; index++) p_wheel->slots[level][index] = NULL;
+    }
+    p_wheel->p_expired = NULL;
+    p_wheel->p_running = NULL;
+    p_wheel->n_pending = 0;
+    p_wheel->stop = 0;
+    if (0 != cc_th_create(&p_wheel->th, NULL, cc__timer_wheel_main, p_wheel)) {
+        cc_cond_destroy(&p_wheel->done_cond);
+        cc_cond_destroy(&p_wheel->cond);
+        cc_mtx_destroy(&p_wheel->mtx);
+        return -2;
+    }
+    return 0;
+}
+
+/* NOTE: stops the service thread, timers still pending never fire and may be freed afterwards */
+static inline int cc_timer_wheel_destroy(cc_timer_wheel *p_wheel) {
+    if (!p_wheel) return -1;
+    cc_mtx_lock(&p_wheel->mtx);
+    p_wheel->stop = 1;
+    cc_cond_signal(&p_wheel->cond);
+    cc_mtx_unlock(&p_wheel->mtx);
+    cc_th_join(p_wheel->th, NULL);
+    cc_cond_destroy(&p_wheel->done_cond);
+    cc_cond_destroy(&p_wheel->cond);
+    cc_mtx_destroy(&p_wheel->mtx);
+    return 0;
+}
+
+static inline int cc_timer_init(cc_timer *p_timer) {
+    if (!p_timer) return -1;
+    p_timer->p_next = NULL;
+    p_timer->pp_prev = NULL;
+    p_timer->func = NULL;
+    p_timer->arg = NULL;
+    p_timer->expires = 0;
+    p_timer->period = 0;
+    p_timer->state = CC__TIMER_IDLE;
+    p_timer->slot = CC__TIMER_NO_SLOT;
+    p_timer->p_wheel = NULL;
+    return 0;
+}
+
+/*
+    Runs "func(arg)" on the service thread once "delay_ms" have passed, then every "period_ms" if not 0.
+    O(1), a pending timer is moved to the new expiry. Callbacks may reschedule or cancel their own timer.
+    NOTE: "p_timer" must stay valid while it is pending or its callback runs. A callback may free its own timer
+    (a periodic one after "cc_timer_cancel"), any other thread must go through "cc_timer_cancel_sync" first.
+*/
+static inline int cc_timer_schedule(cc_timer_wheel *p_wheel, cc_timer *p_timer, uint32_t delay_ms, uint32_t period_ms, void (*func)(void *arg), void *arg) {
+    uint64_t due_ns;
+
+    if (!p_wheel || !p_timer || !func) return -1;
+    cc_mtx_lock(&p_wheel->mtx);
+    if (p_wheel->stop || (p_timer->p_wheel && p_timer->p_wheel != p_wheel && CC__TIMER_IDLE != p_timer->state)) {
+        cc_mtx_unlock(&p_wheel->mtx);
+        return -1;
+    }
+    if (CC__TIMER_PENDING == p_timer->state) {
+        cc__timer_unlink(p_wheel, p_timer);
+        p_wheel->n_pending--;
+    }
+    /* first tick starting at or after the deadline, so timers never fire early */
+    due_ns = cc__time_now_ns() - p_wheel->start_ns + (uint64_t)delay_ms * 1000000U;
+    p_timer->expires = due_ns / p_wheel->tick_ns + (due_ns % p_wheel->tick_ns ? 1 : 0);
+    p_timer->period = (uint64_t)period_ms * 1000000U / p_wheel->tick_ns;
+    if (period_ms && 0 == p_timer->period) p_timer->period = 1;
+    p_timer->func = func;
+    p_timer->arg = arg;
+    p_timer->state = CC__TIMER_PENDING;
+    p_timer->p_wheel = p_wheel;
+    cc__timer_insert(p_wheel, p_timer);
+    p_wheel->n_pending++;
+    if (p_timer->expires < p_wheel->wake_tick) cc_cond_signal(&p_wheel->cond);
+    cc_mtx_unlock(&p_wheel->mtx);
+    return 0;
+}
+
+/* mutex held: takes the timer off the wheel, EBUSY if its callback is running */
+static inline int cc__timer_cancel(cc_timer_wheel *p_wheel, cc_timer *p_timer) {
+    int ret = ENOENT;
+
+    if (CC__TIMER_PENDING == p_timer->state) {
+        cc__timer_unlink(p_wheel, p_timer);
+        p_wheel->n_pending--;
+        p_timer->state = CC__TIMER_IDLE;
+        ret = 0;
+    }
+    if (p_wheel->p_running == p_timer) ret = EBUSY;
+    return ret;
+}
+
+/*
+    O(1). Returns 0 if the timer was pending and won't fire, ENOENT if it isn't scheduled, EBUSY if its
+    callback is running right now (a periodic timer is then not rearmed). Doesn't wait for the callback.
+*/
+static inline int cc_timer_cancel(cc_timer *p_timer) {
+    cc_timer_wheel *p_wheel;
+    int ret;
+
+    if (!p_timer) return -1;
+    if (!(p_wheel = p_timer->p_wheel)) return ENOENT;
+    cc_mtx_lock(&p_wheel->mtx);
+    ret = cc__timer_cancel(p_wheel, p_timer);
+    cc_mtx_unlock(&p_wheel->mtx);
+    return ret;
+}
+
+/*
+    Cancels the timer and waits for a running callback to return: the timer may be freed afterwards.
+    Returns 0 if it was pending or running, ENOENT if it wasn't, EDEADLK from a timer callback while this
+    timer's callback is the one running (it is canceled all the same).
+*/
+static inline int cc_timer_cancel_sync(cc_timer *p_timer) {
+    cc_timer_wheel *p_wheel;
+    int ret;
+
+    if (!p_timer) return -1;
+    if (!(p_wheel = p_timer->p_wheel)) return ENOENT;
+    cc_mtx_lock(&p_wheel->mtx);
+    if (EBUSY == (ret = cc__timer_cancel(p_wheel, p_timer))) {
+        if (cc_th_equal_id(cc_th_self(), p_wheel->th_id)) ret = EDEADLK;
+        else {
+            while (p_wheel->p_running == p_timer) cc_cond_wait(&p_wheel->done_cond, &p_wheel->mtx);
+            ret = 0;
+        }
+    }
+    cc_mtx_unlock(&p_wheel->mtx);
+    return ret;
+}
+
+static inline void cc__pipeline_drive(cc__pipeline *p_pl, cc__pipeline_token *p_token);
+
+static inline void cc__pipeline_input_task(void *arg) {
+    cc__pipeline_drive((cc__pipeline *)arg, NULL);
+}
+
+static inline void cc__pipeline_resume_task(void *arg) {
+    cc__pipeline_token *p_token = (cc__pipeline_token *)arg;
+    cc__pipeline_drive(p_token->p_pipeline, p_token);
+}
+
+/* reads the next item into a free token, NULL if there is none, the input is busy or exhausted */
+static inline cc__pipeline_token *cc__pipeline_input(cc__pipeline *p_pl) {
+    cc__pipeline_serial *p_in = &p_pl->p_serial[0];
+    cc__pipeline_token *p_token;
+    void *p_item;
+    int more = 0;
+
+    cc_mtx_lock(&p_in->mtx);
+    if (p_in->busy || p_pl->done || !(p_token = p_pl->p_free)) {
+        cc_mtx_unlock(&p_in->mtx);
+        return NULL;
+    }
+    p_in->busy = 1;
+    p_pl->p_free = p_token->p_next;
+    cc_mtx_unlock(&p_in->mtx);
+
+    p_item = p_pl->p_stages[0].func(NULL, p_token->index, p_pl->p_stages[0].arg);
+
+    cc_mtx_lock(&p_in->mtx);
+    p_in->busy = 0;
+    if (!p_item) {
+        p_pl->done = 1;
+        p_token->p_next = p_pl->p_free;
+        p_pl->p_free = p_token;
+        p_token = NULL;
+    }
+    else {
+        p_token->p_item = p_item;
+        p_token->seq = p_in->next_seq++;
+        p_token->stage = 1;
+        p_token->acquired = 0;
+        /* tokens recycled while the input was busy are picked up here */
+        more = (NULL != p_pl->p_free);
+    }
+    cc_mtx_unlock(&p_in->mtx);
+    if (more) cc_task_group_run(&p_pl->group, cc__pipeline_input_task, p_pl);
+    return p_token;
+}
+
+/* takes the serial stage "p_token->stage", or parks the token there; returns 1 if taken */
+static inline int cc__pipeline_acquire(cc__pipeline *p_pl, cc__pipeline_token *p_token) {
+    cc__pipeline_serial *p_st = &p_pl->p_serial[p_token->stage];
+    int in_order = (CC_PIPELINE_SERIAL_IN_ORDER == p_pl->p_stages[p_token->stage].mode);
+
+    cc_mtx_lock(&p_st->mtx);
+    if (!p_st->busy && (!in_order || p_token->seq == p_st->next_seq)) {
+        p_st->busy = 1;
+        cc_mtx_unlock(&p_st->mtx);
+        return 1;
+    }
+    /* at most "max_tokens" sequence numbers from "next_seq" on are in flight, so parked slots never collide */
+    if (in_order) p_st->pp_parked[p_token->seq % p_pl->max_tokens] = p_token;
+    else {
+        p_token->p_next = NULL;
+        if (p_st->p_tail) p_st->p_tail->p_next = p_token;
+        else p_st->p_head = p_token;
+        p_st->p_tail = p_token;
+    }
+    cc_mtx_unlock(&p_st->mtx);
+    return 0;
+}
+
+/* leaves serial stage "stage", handing it straight to the next parked token, which is resumed as a task */
+static inline void cc__pipeline_release(cc__pipeline *p_pl, uint32_t stage) {
+    cc__pipeline_serial *p_st = &p_pl->p_serial[stage];
+    cc__pipeline_token *p_next;
+
+    cc_mtx_lock(&p_st->mtx);
+    if (CC_PIPELINE_SERIAL_IN_ORDER == p_pl->p_stages[stage].mode) {
+        p_next = p_st->pp_parked[++p_st->next_seq % p_pl->max_tokens];
+        if (p_next && p_next->seq == p_st->next_seq) p_st->pp_parked[p_next->seq % p_pl->max_tokens] = NULL;
+        else p_next = NULL;
+    }
+    else if ((p_next = p_st->p_head)) {
+        if (!(p_st->p_head = p_next->p_next)) p_st->p_tail = NULL;
+    }
+    if (!p_next) p_st->busy = 0;
+    cc_mtx_unlock(&p_st->mtx);
+
+    if (p_next) {
+        p_next->acquired = 1;
+        if (0 != cc_task_group_run(&p_pl->group, cc__pipeline_resume_task, p_next)) cc__pipeline_drive(p_pl, p_next);
+    }
+}
+
+/* runs the token from its current stage on, returns 0 if it got parked at a serial stage */
+static inline int cc__pipeline_flow(cc__pipeline *p_pl, cc__pipeline_token *p_token) {
+    const cc_pipeline_stage *p_stage;
+    int serial;
+
+    for (; p_token->stage < p_pl->n_stages; p_token->stage++) {
+        p_stage = &p_pl->p_stages[p_token->stage];
+        serial = (CC_PIPELINE_PARALLEL != p_stage->mode);
+        if (serial && !p_token->acquired && !cc__pipeline_acquire(p_pl, p_token)) return 0;
+        p_token->acquired = 0;
+        /* dropped items still pass the serial stages, in order stages must see every sequence number */
+        if (p_token->p_item) p_token->p_item = p_stage->func(p_token->p_item, p_token->index, p_stage->arg);
+        if (serial) cc__pipeline_release(p_pl, p_token->stage);
+    }
+    return 1;
+}
+
+/* moves tokens through the pipeline, a finished token is refilled from the input right away */
+static inline void cc__pipeline_drive(cc__pipeline *p_pl, cc__pipeline_token *p_token) {
+    cc__pipeline_serial *p_in = &p_pl->p_serial[0];
+
+    for (;;) {
+        if (!p_token && !(p_token = cc__pipeline_input(p_pl))) return;
+        if (!cc__pipeline_flow(p_pl, p_token)) return;
+        cc_mtx_lock(&p_in->mtx);
+        p_token->p_next = p_pl->p_free;
+        p_pl->p_free = p_token;
+        cc_mtx_unlock(&p_in->mtx);
+        p_token = NULL;
+    }
+}
+
+/*
+    Runs the stages over the stream read by the first (serial) stage on the pool, and returns when the input
+    is exhausted and every item went through. At most "max_tokens" items are in flight, all state is allocated
+    once per run. Serial stages hand items over directly and never block a worker.
+    NOTE: the caller helps running the pipeline, it can be a pool task itself.
+*/
+static inline int cc_pipeline_run(cc_pool *p_pool, const cc_pipeline_stage *p_stages, uint32_t n_stages, uint32_t max_tokens) {
+    cc__pipeline pl;
+    cc__pipeline_token **pp_parked;
+    uint32_t i, n_in_order = 0;
+    int ret;
+
+    if (!p_pool || !p_stages || 0 == n_stages || 0 == max_tokens || CC_PIPELINE_PARALLEL == p_stages[0].mode) return -1;
+    for (i = 0; i < n_stages; i++) {
+        if (!p_stages[i].func || p_stages[i].mode < CC_PIPELINE_SERIAL_IN_ORDER || p_stages[i].mode > CC_PIPELINE_PARALLEL) return -1;
+        if (i > 0 && CC_PIPELINE_SERIAL_IN_ORDER == p_stages[i].mode) n_in_order++;
+    }
+
+    pl.p_stages = p_stages;
+    pl.n_stages = n_stages;
+    pl.max_tokens = max_tokens;
+    pl.done = 0;
+    pl.p_tokens = (cc__pipeline_token *)malloc(max_tokens * sizeof(cc__pipeline_token));
+    pl.p_serial = (cc__pipeline_serial *)malloc(n_stages * sizeof(cc__pipeline_serial));
+    pp_parked = (cc__pipeline_token **)calloc((size_t)n_in_order * max_tokens + 1, sizeof(cc__pipeline_token *));
+    if (!pl.p_tokens || !pl.p_serial || !pp_parked) {
+        free(pl.p_tokens);
+        free(pl.p_serial);
+        free(pp_parked);
+        return -2;
+    }
+
+    pl.p_free = NULL;
+    for (i = max_tokens; i-- > 0;) {
+        pl.p_tokens[i].index = i;
+        pl.p_tokens[i].p_pipeline = &pl;
+        pl.p_tokens[i].p_next = pl.p_free;
+        pl.p_free = &pl.p_tokens[i];
+    }
+    for (i = 0, n_in_order = 0; i < n_stages; i++) {
+        cc__pipeline_serial *p_st = &pl.p_serial[i];
+        cc_mtx_init(&p_st->mtx);
+        p_st->busy = 0;
+        p_st->next_seq = 0;
+        p_st->pp_parked = NULL;
+        if (i > 0 && CC_PIPELINE_SERIAL_IN_ORDER == p_stages[i].mode) p_st->pp_parked = pp_parked + (size_t)max_tokens * n_in_order++;
+        p_st->p_head = NULL;
+        p_st->p_tail = NULL;
+    }
+
+    cc_task_group_init(&pl.group, p_pool);
+    cc__pipeline_drive(&pl, NULL);
+    ret = cc_task_group_wait(&pl.group);
+    cc_task_group_destroy(&pl.group);
+
+    for (i = 0; i < n_stages; i++) cc_mtx_destroy(&pl.p_serial[i].mtx);
+    free(pl.p_tokens);
+    free(pl.p_serial);
+    free(pp_parked);
+    return ret;
+}
+
+static inline int cc_graph_init(cc_graph *p_graph) {
+    if (!p_graph) return -1;
+    p_graph->pp_nodes = NULL;
+    p_graph->n_nodes = 0;
+    p_graph->cap_nodes = 0;
+    p_graph->n_run = 0;
+    return 0;
+}
+
+static inline int cc_graph_destroy(cc_graph *p_graph) {
+    uint32_t i;
+
+    if (!p_graph) return -1;
+    for (i = 0; i < p_graph->n_nodes; i++) {
+        free(p_graph->pp_nodes[i]->pp_succ);
+        free(p_graph->pp_nodes[i]);
+    }
+    free(p_graph->pp_nodes);
+    return cc_graph_init(p_graph);
+}
+
+/* returns the new node running "func(arg)", NULL on allocation failure */
+static inline cc_graph_node *cc_graph_add_node(cc_graph *p_graph, void (*func)(void *arg), void *arg) {
+    cc_graph_node *p_node, **pp_nodes;
+    uint32_t cap;
+
+    if (!p_graph || !func) return NULL;
+    if (p_graph->n_nodes == p_graph->cap_nodes) {
+        cap = p_graph->cap_nodes ? 2 * p_graph->cap_nodes : 16;
+        if (!(pp_nodes = (cc_graph_node **)realloc((void *)p_graph->pp_nodes, cap * sizeof(cc_graph_node *)))) return NULL;
+        p_graph->pp_nodes = pp_nodes;
+        p_graph->cap_nodes = cap;
+    }
+    if (!(p_node = (cc_graph_node *)malloc(sizeof(cc_graph_node)))) return NULL;
+    p_node->func = func;
+    p_node->arg = arg;
+    p_node->n_deps = 0;
+    p_node->pending = 0;
+    p_node->n_succ = 0;
+    p_node->cap_succ = 0;
+    p_node->pp_succ = NULL;
+    p_node->p_graph = p_graph;
+    p_graph->pp_nodes[p_graph->n_nodes++] = p_node;
+    return p_node;
+}
+
+/* "p_to" runs after "p_from", both of the same graph. NOTE: not while the graph runs */
+static inline int cc_graph_add_edge(cc_graph_node *p_from, cc_graph_node *p_to) {
+    cc_graph_node **pp_succ;
+    uint32_t cap;
+
+    if (!p_from || !p_to || p_from == p_to || p_from->p_graph != p_to->p_graph) return -1;
+    if (p_from->n_succ == p_from->cap_succ) {
+        cap = p_from->cap_succ ? 2 * p_from->cap_succ : 4;
+        if (!(pp_succ = (cc_graph_node **)realloc((void *)p_from->pp_succ, cap * sizeof(cc_graph_node *)))) return -2;
+        p_from->pp_succ = pp_succ;
+        p_from->cap_succ = cap;
+    }
+    p_from->pp_succ[p_from->n_succ++] = p_to;
+    p_to->n_deps++;
+    p_to->pending++;
+    return 0;
+}
+
+/*
+    Runs a ready node, then releases its successors: those becoming ready go to the pool, except the last
+    one which runs right here without a queue round trip.
+*/
+static inline void cc__graph_node_task(void *arg) {
+    cc_graph_node *p_node = (cc_graph_node *)arg, *p_next, *p_succ;
+    uint32_t i;
+
+    for (; p_node; p_node = p_next) {
+        /* no predecessor is left to decrement it this run, so it is reset for the next one already */
+        cc_atomic_store_u32(&p_node->pending, p_node->n_deps, CC_MO_RELAXED);
+        p_node->func(p_node->arg);
+        cc_atomic_fetch_add_u32(&p_node->p_graph->n_run, 1, CC_MO_RELAXED);
+
+        p_next = NULL;
+        for (i = 0; i < p_node->n_succ; i++) {
+            p_succ = p_node->pp_succ[i];
+            if (1 != cc_atomic_fetch_sub_u32(&p_succ->pending, 1, CC_MO_ACQ_REL)) continue;
+            if (p_next && 0 != cc_task_group_run(&p_node->p_graph->group, cc__graph_node_task, p_next))
+                cc__graph_node_task(p_next);
+            p_next = p_succ;
+        }
+    }
+}
+
+/*
+    Runs every node once on the pool, each after all its predecessors, and returns when the graph is done.
+    Counters reset as nodes run, so there is no per run setup beyond submitting the nodes without predecessors.
+    Returns EDEADLK if a cycle kept nodes from running. NOTE: a graph runs once at a time, the caller helps
+    running it and can be a pool task itself.
+*/
+static inline int cc_graph_run(cc_graph *p_graph, cc_pool *p_pool) {
+    uint32_t i;
+    int ret;
+
+    if (!p_graph || !p_pool) return -1;
+    p_graph->n_run = 0;
+    cc_task_group_init(&p_graph->group, p_pool);
+    for (i = 0; i < p_graph->n_nodes; i++) {
+        if (0 != p_graph->pp_nodes[i]->n_deps) continue;
+        if (0 != cc_task_group_run(&p_graph->group, cc__graph_node_task, p_graph->pp_nodes[i]))
+            cc__graph_node_task(p_graph->pp_nodes[i]);
+    }
+    ret = cc_task_group_wait(&p_graph->group);
+    cc_task_group_destroy(&p_graph->group);
+    if (0 == ret && p_graph->n_run != p_graph->n_nodes) {
+        for (i = 0; i < p_graph->n_nodes; i++) p_graph->pp_nodes[i]->pending = p_graph->pp_nodes[i]->n_deps;
+        ret = EDEADLK;
+    }
+    return ret;
+}
+
+#if defined(CC__FIBER_ASM)
+/*
+    cc__fiber_switch_asm(&p_from->p_sp, p_to->p_sp) saves the callee-saved registers (and the FP control state)
+    on the current stack, stores the stack pointer and restores the other context the same way. A new context
+    "returns" into cc__fiber_start, which calls the entry function kept in a callee-saved register.
+*/
+void cc__fiber_switch_asm(void **pp_save_sp, void *p_sp);
+void cc__fiber_start(void);
+
+#if defined(__x86_64__)
+__asm__(
+    ".pushsection .text\n"
+    ".weak cc__fiber_switch_asm\n"
+    ".hidden cc__fiber_switch_asm\n"
+    ".type cc__fiber_switch_asm, @function\n"
+    "cc__fiber_switch_asm:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size cc__fiber_switch_asm, .-cc__fiber_switch_asm\n"
+    ".weak cc__fiber_start\n"
+    ".hidden cc__fiber_start\n"
+    ".type cc__fiber_start, @function\n"
+    "cc__fiber_start:\n"
+    "    movq %rbx, %rdi\n"
+    "    callq *%r12\n"
+    "    ud2\n"
+    ".size cc__fiber_start, .-cc__fiber_start\n"
+    ".popsection\n"
+);
+#define CC__FIBER_FRAME_WORDS   8   /* fp control, r15, r14, r13, r12 (entry), rbx (arg), rbp, return address */
+#elif defined(__aarch64__)
+__asm__(
+    ".pushsection .text\n"
+    ".weak cc__fiber_switch_asm\n"
+    ".hidden cc__fiber_switch_asm\n"
+    ".type cc__fiber_switch_asm, %function\n"
+    "cc__fiber_switch_asm:\n"
+    "    sub sp, sp, #176\n"
+    "    stp x19, x20, [sp, #0]\n"
+    "    stp x21, x22, [sp, #16]\n"
+    "    stp x23, x24, [sp, #32]\n"
+    "    stp x25, x26, [sp, #48]\n"
+    "    stp x27, x28, [sp, #64]\n"
+    "    stp x29, x30, [sp, #80]\n"
+    "    stp d8, d9, [sp, #96]\n"
+    "    stp d10, d11, [sp, #112]\n"
+    "    stp d12, d13, [sp, #128]\n"
+    "    stp d14, d15, [sp, #144]\n"
+    "    mrs x2, fpcr\n"
+    "    str x2, [sp, #160]\n"
+    "    mov x2, sp\n"
+    "    str x2, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldp x19, x20, [sp, #0]\n"
+    "    ldp x21, x22, [sp, #16]\n"
+    "    ldp x23, x24, [sp, #32]\n"
+    "    ldp x25, x26, [sp, #48]\n"
+    "    ldp x27, x28, [sp, #64]\n"
+    "    ldp x29, x30, [sp, #80]\n"
+    "    ldp d8, d9, [sp, #96]\n"
+    "    ldp d10, d11, [sp, #112]\n"
+    "    ldp d12, d13, [sp, #128]\n"
+    "    ldp d14, d15, [sp, #144]\n"
+    "    ldr x2, [sp, #160]\n"
+    "    msr fpcr, x2\n"
+    "    add sp, sp, #176\n"
+    "    ret\n"
+    ".size cc__fiber_switch_asm, .-cc__fiber_switch_asm\n"
+    ".weak cc__fiber_start\n"
+    ".hidden cc__fiber_start\n"
+    ".type cc__fiber_start, %function\n"
+    "cc__fiber_start:\n"
+    "    mov x0, x19\n"
+    "    blr x20\n"
+    "    brk #0\n"
+    ".size cc__fiber_start, .-cc__fiber_start\n"
+    ".popsection\n"
+);
+#define CC__FIBER_FRAME_WORDS   22  /* x19 (arg), x20 (entry), x21-x28, x29, x30 (return address), d8-d15, fpcr, padding */
+#endif
+#endif
+
+#if defined(CC__TSAN)
+void *__tsan_get_current_fiber(void);
+void *__tsan_create_fiber(unsigned flags);
+void __tsan_destroy_fiber(void *fiber);
+void __tsan_switch_to_fiber(void *fiber, unsigned flags);
+#endif
+#if defined(CC__ASAN)
+void __sanitizer_start_switch_fiber(void **fake_stack_save, const void *bottom, size_t size);
+void __sanitizer_finish_switch_fiber(void *fake_stack_save, const void **bottom_old, size_t *size_old);
+void __asan_unpoison_memory_region(void const volatile *addr, size_t size);
+#endif
+
+#define CC__FIBER_YIELD     0U
+#define CC__FIBER_JOIN      1U
+#define CC__FIBER_EXIT      2U
+
+/* "p_joiner" of a finished fiber */
+#define CC__FIBER_JOINED(p_fiber)   ((cc_fiber *)(void *)&(p_fiber)->p_joiner)
+
+/* TLS slot holding the stack of the fiber the calling thread runs, if any */
+CC__SHARED cc_tls_key cc__fiber_key = 0;
+CC__SHARED cc_once cc__fiber_key_once = CC_ONCE_INIT;
+
+/* process wide cache of fiber stacks */
+CC__SHARED cc_mtx cc__fiber_stacks_mtx = { 0, 0 };
+CC__SHARED cc__fiber_stack *cc__fiber_stacks = NULL;
+CC__SHARED uint32_t cc__fiber_n_stacks = 0;
+
+static inline void cc__fiber_key_create(void) {
+    cc_tls_key_create(&cc__fiber_key);
+}
+
+static inline cc__fiber_stack *cc__fiber_current_stack(void) {
+    cc_call_once(&cc__fiber_key_once, cc__fiber_key_create);
+    return (cc__fiber_stack *)cc_tls_get(cc__fiber_key);
+}
+
+static inline void cc__fiber_switch(cc__fiber_ctx *p_from, cc__fiber_ctx *p_to) {
+#if defined(CC__FIBER_ASM)
+    cc__fiber_switch_asm(&p_from->p_sp, p_to->p_sp);
+#elif defined(CC_POSIX)
+    swapcontext(&p_from->uc, &p_to->uc);
+#elif defined(CC_WINDOWS)
+    (void)p_from;
+    SwitchToFiber(p_to->p_fiber);
+#endif
+}
+
+/* switches from a fiber back to its carrier, "action" tells the carrier what to do with it */
+static inline void cc__fiber_suspend(cc__fiber_stack *p_stack, uint32_t action) {
+    p_stack->p_fiber->action = action;
+#if defined(CC__TSAN)
+    __tsan_switch_to_fiber(p_stack->p_tsan_carrier, 0);
+#endif
+#if defined(CC__ASAN)
+    __sanitizer_start_switch_fiber(&p_stack->p_asan_fake, p_stack->p_asan_carrier, p_stack->asan_carrier_size);
+#endif
+    cc__fiber_switch(&p_stack->ctx, p_stack->p_carrier);
+#if defined(CC__ASAN)
+    __sanitizer_finish_switch_fiber(p_stack->p_asan_fake, &p_stack->p_asan_carrier, &p_stack->asan_carrier_size);
+#endif
+}
+
+/* bottom of every stack, runs the fiber bound to it, then waits for the next one */
+static void cc__fiber_entry(void *arg) {
+    cc__fiber_stack *p_stack = (cc__fiber_stack *)arg;
+
+#if defined(CC__ASAN)
+    __sanitizer_finish_switch_fiber(NULL, &p_stack->p_asan_carrier, &p_stack->asan_carrier_size);
+#endif
+    for (;;) {
+        p_stack->p_fiber->func(p_stack->p_fiber->arg);
+        cc__fiber_suspend(p_stack, CC__FIBER_EXIT);
+    }
+}
+
+#if defined(CC_POSIX) && !defined(CC__FIBER_ASM)
+static void cc__fiber_entry_uc(unsigned hi, unsigned lo) {
+    cc__fiber_entry((void *)(uintptr_t)(((uint64_t)hi << 32) | lo));
+}
+
+/* kept out of line, getcontext() returns twice as far as the compiler knows */
+static CC__NOINLINE void cc__fiber_getcontext(ucontext_t *p_uc) {
+    getcontext(p_uc);
+}
+#elif defined(CC_WINDOWS)
+static VOID CALLBACK cc__fiber_entry_win(LPVOID arg) {
+    cc__fiber_entry(arg);
+}
+#endif
+
+static inline void cc__fiber_stack_free(cc__fiber_stack *p_stack) {
+#if defined(CC__TSAN)
+    __tsan_destroy_fiber(p_stack->p_tsan_fiber);
+#endif
+#if defined(CC_POSIX)
+  #if defined(CC__ASAN)
+    __asan_unpoison_memory_region(p_stack->p_mem, p_stack->size);
+  #endif
+    munmap(p_stack->p_mem, p_stack->size);
+#elif defined(CC_WINDOWS)
+    DeleteFiber(p_stack->ctx.p_fiber);
+#endif
+    free(p_stack);
+}
+
+/* maps a stack with a guard page below it and prepares a context entering "cc__fiber_entry" */
+static CC__NOINLINE cc__fiber_stack *cc__fiber_stack_new(void) {
+    cc__fiber_stack *p_stack = (cc__fiber_stack *)malloc(sizeof(cc__fiber_stack));
+#if defined(CC_POSIX)
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = (CC_FIBER_STACK_SIZE + page - 1) / page * page;
+  #if defined(CC__FIBER_ASM)
+    uint64_t *p_sp;
+  #endif
+#endif
+
+    if (!p_stack) return NULL;
+    p_stack->p_next = NULL;
+    p_stack->p_fiber = NULL;
+    p_stack->p_carrier = NULL;
+#if defined(CC__ASAN)
+    p_stack->p_asan_fake = NULL;
+    p_stack->p_asan_carrier = NULL;
+    p_stack->asan_carrier_size = 0;
+#endif
+
+#if defined(CC_POSIX)
+    p_stack->size = size + page;
+    p_stack->p_mem = mmap(NULL, p_stack->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == p_stack->p_mem) {
+        free(p_stack);
+        return NULL;
+    }
+    /* stacks grow down, an overflow faults here rather than running into the neighbouring mapping */
+    if (0 != mprotect(p_stack->p_mem, page, PROT_NONE)) {
+        munmap(p_stack->p_mem, p_stack->size);
+        free(p_stack);
+        return NULL;
+    }
+  #if defined(CC__FIBER_ASM)
+    p_sp = (uint64_t *)(void *)((char *)p_stack->p_mem + p_stack->size) - CC__FIBER_FRAME_WORDS;
+    memset(p_sp, 0, CC__FIBER_FRAME_WORDS * sizeof(uint64_t));
+    #if defined(__x86_64__)
+    p_sp[0] = 0x0000037F00001F80ULL;  /* default MXCSR and x87 control word */
+    p_sp[4] = (uint64_t)(uintptr_t)cc__fiber_entry;
+    p_sp[5] = (uint64_t)(uintptr_t)p_stack;
+    p_sp[7] = (uint64_t)(uintptr_t)cc__fiber_start;
+    #elif defined(__aarch64__)
+    p_sp[0] = (uint64_t)(uintptr_t)p_stack;
+    p_sp[1] = (uint64_t)(uintptr_t)cc__fiber_entry;
+    p_sp[11] = (uint64_t)(uintptr_t)cc__fiber_start;
+    p_sp[20] = 0;  /* default FPCR: round to nearest, no flush to zero */
+    #endif
+    p_stack->ctx.p_sp = p_sp;
+  #else
+    cc__fiber_getcontext(&p_stack->ctx.uc);
+    p_stack->ctx.uc.uc_stack.ss_sp = (char *)p_stack->p_mem + page;
+    p_stack->ctx.uc.uc_stack.ss_size = size;
+    p_stack->ctx.uc.uc_link = NULL;
+    makecontext(&p_stack->ctx.uc, (void (*)(void))cc__fiber_entry_uc, 2,
+                (unsigned)((uint64_t)(uintptr_t)p_stack >> 32), (unsigned)(uintptr_t)p_stack);
+  #endif
+#elif defined(CC_WINDOWS)
+    /* Windows fibers come with their own guarded stack */
+    p_stack->p_mem = NULL;
+    p_stack->size = CC_FIBER_STACK_SIZE;
+    p_stack->ctx.p_fiber = CreateFiberEx(0, CC_FIBER_STACK_SIZE, FIBER_FLAG_FLOAT_SWITCH, cc__fiber_entry_win, p_stack);
+    if (!p_stack->ctx.p_fiber) {
+        free(p_stack);
+        return NULL;
+    }
+#endif
+#if defined(CC__TSAN)
+    p_stack->p_tsan_fiber = __tsan_create_fiber(0);
+#endif
+    return p_stack;
+}
+
+static inline cc__fiber_stack *cc__fiber_stack_acquire(void) {
+    cc__fiber_stack *p_stack;
+
+    cc_mtx_lock(&cc__fiber_stacks_mtx);
+    if ((p_stack = cc__fiber_stacks)) {
+        cc__fiber_stacks = p_stack->p_next;
+        cc__fiber_n_stacks--;
+    }
+    cc_mtx_unlock(&cc__fiber_stacks_mtx);
+    return p_stack ? p_stack : cc__fiber_stack_new();
+}
+
+static inline void cc__fiber_stack_release(cc__fiber_stack *p_stack) {
+    cc_mtx_lock(&cc__fiber_stacks_mtx);
+    if (cc__fiber_n_stacks < CC_FIBER_STACK_CACHE) {
+        p_stack->p_next = cc__fiber_stacks;
+        cc__fiber_stacks = p_stack;
+        cc__fiber_n_stacks++;
+        p_stack = NULL;
+    }
+    cc_mtx_unlock(&cc__fiber_stacks_mtx);
+    if (p_stack) cc__fiber_stack_free(p_stack);
+}
+
+static inline void cc__fiber_resume_task(void *arg);
+
+static inline void cc__fiber_schedule(cc_fiber *p_fiber) {
+    if (0 != cc_pool_submit(p_fiber->p_pool, cc__fiber_resume_task, p_fiber)) cc__fiber_resume_task(p_fiber);
+}
+
+/*
+    Pool task running a fiber until it switches out, then acting on why: requeue it (yield), register it
+    with the fiber it joins, or finish it. Acting only once the fiber's context is saved means another
+    carrier can never resume a fiber still running here.
+*/
+static inline void cc__fiber_resume_task(void *arg) {
+    cc_fiber *p_fiber = (cc_fiber *)arg, *p_other, *p_expected = NULL;
+    cc__fiber_stack *p_stack = p_fiber->p_stack;
+    cc__fiber_stack *p_prev = cc__fiber_current_stack();  /* set when a fiber helps running pool tasks */
+    cc__fiber_ctx carrier;
+#if defined(CC__ASAN)
+    void *p_fake = NULL;
+#endif
+#if defined(CC_WINDOWS)
+    int converted = !IsThreadAFiber();  /* a plain thread is turned into a fiber for the switch, and back after */
+#endif
+
+#if defined(CC_WINDOWS)
+    carrier.p_fiber = converted ? ConvertThreadToFiberEx(NULL, FIBER_FLAG_FLOAT_SWITCH) : GetCurrentFiber();
+#endif
+    p_stack->p_carrier = &carrier;
+    cc_tls_set(cc__fiber_key, p_stack);
+#if defined(CC__TSAN)
+    p_stack->p_tsan_carrier = __tsan_get_current_fiber();
+    __tsan_switch_to_fiber(p_stack->p_tsan_fiber, 0);
+#endif
+#if defined(CC__ASAN)
+    __sanitizer_start_switch_fiber(&p_fake, (char *)p_stack->p_mem + (p_stack->size - CC_FIBER_STACK_SIZE), CC_FIBER_STACK_SIZE);
+#endif
+    cc__fiber_switch(&carrier, &p_stack->ctx);
+#if defined(CC__ASAN)
+    __sanitizer_finish_switch_fiber(p_fake, NULL, NULL);
+#endif
+#if defined(CC_WINDOWS)
+    if (converted) ConvertFiberToThread();
+#endif
+    cc_tls_set(cc__fiber_key, p_prev);
+
+    if (CC__FIBER_YIELD == p_fiber->action) cc__fiber_schedule(p_fiber);
+    else if (CC__FIBER_JOIN == p_fiber->action) {
+        p_other = p_fiber->p_target;
+        if (!cc_atomic_cas_ptr((void **)&p_other->p_joiner, (void **)&p_expected, p_fiber, CC_MO_ACQ_REL, CC_MO_ACQUIRE)) {
+            if (p_expected != CC__FIBER_JOINED(p_other)) p_fiber->p_target = NULL;  /* joined by another fiber */
+            cc__fiber_schedule(p_fiber);
+        }
+    }
+    else {
+        p_fiber->p_stack = NULL;
+        cc__fiber_stack_release(p_stack);
+        p_other = (cc_fiber *)cc_atomic_exchange_ptr((void **)&p_fiber->p_joiner, CC__FIBER_JOINED(p_fiber), CC_MO_ACQ_REL);
+        /* the fiber may be freed by a joining thread from here on, only its address is used for the wake */
+        cc_atomic_store_u32(&p_fiber->done, 1, CC_MO_RELEASE);
+        cc_wake_all(&p_fiber->done);
+        if (p_other) cc__fiber_schedule(p_other);
+    }
+}
+
+/*
+    Starts "func(arg)" as a fiber on a pooled stack, carried by the workers of "p_pool": it runs on whichever
+    worker picks it up and may move between them at every yield or join.
+    NOTE: "p_fiber" must stay valid until the fiber is joined.
+*/
+static inline int cc_fiber_create(cc_fiber *p_fiber, cc_pool *p_pool, void (*func)(void *arg), void *arg) {
+    cc__fiber_stack *p_stack;
+    int ret;
+
+    if (!p_fiber || !p_pool || !func) return -1;
+    if (!(p_stack = cc__fiber_stack_acquire())) return -2;
+    p_fiber->func = func;
+    p_fiber->arg = arg;
+    p_fiber->p_pool = p_pool;
+    p_fiber->p_stack = p_stack;
+    p_fiber->p_joiner = NULL;
+    p_fiber->p_target = NULL;
+    p_fiber->action = CC__FIBER_YIELD;
+    p_fiber->done = 0;
+    p_stack->p_fiber = p_fiber;
+    if (0 != (ret = cc_pool_submit(p_pool, cc__fiber_resume_task, p_fiber))) cc__fiber_stack_release(p_stack);
+    return ret;
+}
+
+/* the running fiber, NULL outside of fibers */
+static inline cc_fiber *cc_fiber_self(void) {
+    cc__fiber_stack *p_stack = cc__fiber_current_stack();
+    return p_stack ? p_stack->p_fiber : NULL;
+}
+
+/* lets the carrier run other work and requeues the fiber, returns -1 outside of fibers */
+static inline int cc_fiber_yield(void) {
+    cc__fiber_stack *p_stack = cc__fiber_current_stack();
+
+    if (!p_stack) return -1;
+    cc__fiber_suspend(p_stack, CC__FIBER_YIELD);
+    return 0;
+}
+
+/*
+    Waits for the fiber to finish. A fiber calling it is parked without holding its carrier, a thread blocks.
+    Returns EDEADLK for a fiber joining itself and EBUSY if another fiber already joins the same one.
+*/
+static inline int cc_fiber_join(cc_fiber *p_fiber) {
+    cc__fiber_stack *p_stack;
+    cc_fiber *p_self;
+
+    if (!p_fiber) return -1;
+    if (cc_atomic_load_u32(&p_fiber->done, CC_MO_ACQUIRE)) return 0;
+    if ((p_stack = cc__fiber_current_stack())) {
+        p_self = p_stack->p_fiber;
+        if (p_self == p_fiber) return EDEADLK;
+        p_self->p_target = p_fiber;
+        cc__fiber_suspend(p_stack, CC__FIBER_JOIN);
+        if (!p_self->p_target) return EBUSY;
+        /* resumed right after the target gave up its stack, "done" follows shortly */
+        while (!cc_atomic_load_u32(&p_fiber->done, CC_MO_ACQUIRE)) cc_fiber_yield();
+        return 0;
+    }
+    while (!cc_atomic_load_u32(&p_fiber->done, CC_MO_ACQUIRE)) cc_wait(&p_fiber->done, 0, NULL);
+    return 0;
+}
+
+static inline void cc_co_init(cc_co *p_co) {
+    p_co->line = 0;
+}
+
+static inline int cc_co_done(const cc_co *p_co) {
+    return CC__CO_FINISHED == p_co->line;
+}
 
 #ifdef __cplusplus
 }
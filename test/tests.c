@@ -2,6 +2,7 @@
 #include "../src/ccurrent.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef CC_POSIX
 #include <time.h>
@@ -344,6 +345,1842 @@ void test_cc_tls_cleanup(void) {
 }
 
 
+// Shared state for the cc_call_once tests
+static cc_once g_test_once = CC_ONCE_INIT;
+static int g_test_once_calls = 0;
+static cc_tls_key g_test_once_key;
+
+// Init function creating a shared TLS key, slow enough for callers to pile up
+void once_init_func(void) {
+    g_test_once_calls++;
+    cc_tls_key_create(&g_test_once_key);
+#ifdef CC_POSIX
+    nanosleep((const struct timespec[]){{0, 5000000L}}, NULL);
+#elif defined(CC_WINDOWS)
+    Sleep(5);
+#endif
+}
+
+// Thread function lazily creating the key through cc_call_once
+CC_TH_FUNC_RET thread_func_once(void *arg) {
+    cc_call_once(&g_test_once, once_init_func);
+    TEST_ASSERT_EQUAL_INT(0, cc_tls_set(g_test_once_key, arg));
+    TEST_ASSERT_EQUAL_PTR(arg, cc_tls_get(g_test_once_key));
+    CC_TH_RETURN(0);
+}
+
+// Test cc_call_once running the init function exactly once across threads
+void test_cc_call_once(void) {
+    cc_th th[4];
+
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_once, (void *)(intptr_t)(i + 1)));
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_call_once(&g_test_once, once_init_func));
+    TEST_ASSERT_EQUAL_INT(1, g_test_once_calls);
+    TEST_ASSERT_EQUAL_INT(1, (int)sizeof(cc_once));
+    cc_tls_key_delete(g_test_once_key);
+}
+
+// Shared words for the wait-on-address tests
+static uint32_t g_test_wait_word = 0;
+static uint64_t g_test_wait_word64 = 0;
+
+// Thread function blocking on the 32-bit word until it becomes non-zero
+CC_TH_FUNC_RET thread_func_wait32(void *arg) {
+    (void)arg;
+    while (0 == cc_atomic_load_u32(&g_test_wait_word, CC_MO_ACQUIRE))
+        cc_wait(&g_test_wait_word, 0, NULL);
+    CC_TH_RETURN(0);
+}
+
+// Thread function blocking on the 64-bit word until its high half changes
+CC_TH_FUNC_RET thread_func_wait64(void *arg) {
+    (void)arg;
+    while (0x100000000ULL == cc_atomic_load_u64(&g_test_wait_word64, CC_MO_ACQUIRE))
+        cc_wait64(&g_test_wait_word64, 0x100000000ULL, NULL);
+    CC_TH_RETURN(0);
+}
+
+// Test cc_wait returning on value mismatch and on timeout
+void test_cc_wait_timeout(void) {
+    uint32_t word = 1;
+    uint64_t word64 = 1;
+    struct timespec deadline;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_wait(&word, 0, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_wait64(&word64, 0, NULL));
+
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+    while (0 == cc_wait(&word, 1, &deadline)) {}
+    TEST_ASSERT_TRUE(cc__time_left_ns(&deadline) <= 0);
+
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+    while (0 == cc_wait64(&word64, 1, &deadline)) {}
+    TEST_ASSERT_TRUE(cc__time_left_ns(&deadline) <= 0);
+}
+
+// Test cc_wake_all / cc_wake_all64 releasing blocked threads
+void test_cc_wait_and_wake(void) {
+    cc_th th[4];
+
+    g_test_wait_word = 0;
+    g_test_wait_word64 = 0x100000000ULL;
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_wait32, NULL));
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i + 2], NULL, thread_func_wait64, NULL));
+    }
+#ifdef CC_POSIX
+    nanosleep((const struct timespec[]){{0, 10000000L}}, NULL);
+#elif defined(CC_WINDOWS)
+    Sleep(10);
+#endif
+
+    cc_atomic_store_u32(&g_test_wait_word, 1, CC_MO_RELEASE);
+    cc_wake_all(&g_test_wait_word);
+    cc_atomic_store_u64(&g_test_wait_word64, 0x200000000ULL, CC_MO_RELEASE);
+    cc_wake_one64(&g_test_wait_word64);
+    cc_wake_one64(&g_test_wait_word64);
+
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+}
+
+// Shared state for the mutex stress test
+static cc_mtx g_test_mtx = CC_MTX_INITIALIZER;
+static long g_test_mtx_counter = 0;
+
+// Thread function incrementing a shared counter under cc_mtx
+CC_TH_FUNC_RET thread_func_mtx(void *arg) {
+    int iterations = (int)(intptr_t)arg;
+    for (int i = 0; i < iterations; i++) {
+        cc_mtx_lock(&g_test_mtx);
+        g_test_mtx_counter++;
+        cc_mtx_unlock(&g_test_mtx);
+    }
+    CC_TH_RETURN(0);
+}
+
+// Test cc_mtx_init, cc_mtx_lock, cc_mtx_trylock, cc_mtx_unlock and cc_mtx_destroy
+void test_cc_mtx_lock_and_trylock(void) {
+    cc_mtx mtx;
+    TEST_ASSERT_EQUAL_INT(0, cc_mtx_init(&mtx));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_mtx_lock(&mtx));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_mtx_trylock(&mtx));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_mtx_destroy(&mtx));
+    TEST_ASSERT_EQUAL_INT(0, cc_mtx_unlock(&mtx));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_mtx_trylock(&mtx));
+    TEST_ASSERT_EQUAL_INT(0, cc_mtx_unlock(&mtx));
+    TEST_ASSERT_EQUAL_INT(0, cc_mtx_destroy(&mtx));
+}
+
+// Test cc_mtx_timedlock expiring on a held mutex
+void test_cc_mtx_timedlock(void) {
+    cc_mtx mtx = CC_MTX_INITIALIZER;
+    struct timespec deadline;
+
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+    TEST_ASSERT_EQUAL_INT(0, cc_mtx_timedlock(&mtx, &deadline));
+
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+    TEST_ASSERT_EQUAL_INT(ETIMEDOUT, cc_mtx_timedlock(&mtx, &deadline));
+
+    cc_mtx_unlock(&mtx);
+}
+
+// Test cc_mtx mutual exclusion across threads
+void test_cc_mtx_contention(void) {
+    cc_th th[4];
+    int iterations = 20000;
+
+    g_test_mtx_counter = 0;
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_mtx, (void *)(intptr_t)iterations));
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+
+    TEST_ASSERT_EQUAL_INT(4 * iterations, (int)g_test_mtx_counter);
+}
+
+
+// Shared state for the rwlock exclusion test: writers keep "a" and "b" equal
+static cc_rwlock g_test_rw;
+static long g_test_rw_a = 0, g_test_rw_b = 0;
+static uint32_t g_test_rw_violations = 0;
+
+// Thread function alternating between reads (checking the invariant) and writes
+CC_TH_FUNC_RET thread_func_rwlock(void *arg) {
+    int id = (int)(intptr_t)arg;
+    for (int i = 0; i < 2000; i++) {
+        if ((i + id) % 10 == 0) {
+            cc_rwlock_wrlock(&g_test_rw);
+            g_test_rw_a++;
+            g_test_rw_b++;
+            cc_rwlock_wrunlock(&g_test_rw);
+        }
+        else {
+            cc_rwlock_rdlock(&g_test_rw);
+            if (g_test_rw_a != g_test_rw_b) cc_atomic_fetch_add_u32(&g_test_rw_violations, 1, CC_MO_RELAXED);
+            cc_rwlock_rdunlock(&g_test_rw);
+        }
+    }
+    CC_TH_RETURN(0);
+}
+
+// Test cc_rwlock try variants: readers share, writers exclude
+void test_cc_rwlock_try(void) {
+    cc_rwlock rw;
+    TEST_ASSERT_EQUAL_INT(0, cc_rwlock_init(&rw));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_rwlock_rdlock(&rw));
+    TEST_ASSERT_EQUAL_INT(0, cc_rwlock_tryrdlock(&rw));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_rwlock_trywrlock(&rw));
+    cc_rwlock_rdunlock(&rw);
+    cc_rwlock_rdunlock(&rw);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_rwlock_trywrlock(&rw));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_rwlock_tryrdlock(&rw));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_rwlock_trywrlock(&rw));
+    cc_rwlock_wrunlock(&rw);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_rwlock_destroy(&rw));
+}
+
+// Test cc_rwlock reader/writer exclusion across threads
+void test_cc_rwlock_exclusion(void) {
+    cc_th th[4];
+
+    cc_rwlock_init(&g_test_rw);
+    g_test_rw_a = g_test_rw_b = 0;
+    g_test_rw_violations = 0;
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_rwlock, (void *)(intptr_t)i));
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+
+    TEST_ASSERT_EQUAL_UINT32(0, g_test_rw_violations);
+    TEST_ASSERT_EQUAL_INT(4 * 200, (int)g_test_rw_a);
+    TEST_ASSERT_EQUAL_INT(0, cc_rwlock_destroy(&g_test_rw));
+}
+
+
+// Shared state for the condition variable tests
+static cc_mtx g_test_cond_mtx = CC_MTX_INITIALIZER;
+static cc_cond g_test_cond = CC_COND_INITIALIZER;
+static int g_test_cond_ready = 0;
+static int g_test_cond_woken = 0;
+
+// Thread function waiting on the shared condition until "ready" is set
+CC_TH_FUNC_RET thread_func_cond_wait(void *arg) {
+    (void)arg;
+    cc_mtx_lock(&g_test_cond_mtx);
+    while (!g_test_cond_ready)
+        cc_cond_wait(&g_test_cond, &g_test_cond_mtx);
+    g_test_cond_woken++;
+    cc_mtx_unlock(&g_test_cond_mtx);
+    CC_TH_RETURN(0);
+}
+
+// Test cc_cond_signal waking a single waiter
+void test_cc_cond_signal(void) {
+    cc_th th;
+
+    g_test_cond_ready = 0;
+    g_test_cond_woken = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th, NULL, thread_func_cond_wait, NULL));
+
+    cc_mtx_lock(&g_test_cond_mtx);
+    g_test_cond_ready = 1;
+    cc_cond_signal(&g_test_cond);
+    cc_mtx_unlock(&g_test_cond_mtx);
+
+    cc_th_join(th, NULL);
+    TEST_ASSERT_EQUAL_INT(1, g_test_cond_woken);
+}
+
+// Test cc_cond_broadcast waking (requeueing) every waiter
+void test_cc_cond_broadcast(void) {
+    cc_th th[4];
+
+    g_test_cond_ready = 0;
+    g_test_cond_woken = 0;
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_cond_wait, NULL));
+
+#ifdef CC_POSIX
+    nanosleep((const struct timespec[]){{0, 10000000L}}, NULL);
+#elif defined(CC_WINDOWS)
+    Sleep(10);
+#endif
+    cc_mtx_lock(&g_test_cond_mtx);
+    g_test_cond_ready = 1;
+    cc_cond_broadcast(&g_test_cond);
+    cc_mtx_unlock(&g_test_cond_mtx);
+
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+    TEST_ASSERT_EQUAL_INT(4, g_test_cond_woken);
+    TEST_ASSERT_EQUAL_INT(0, cc_cond_destroy(&g_test_cond));
+}
+
+// Thread function doing one timed wait on the shared condition, with a 50 ms deadline
+static int g_test_cond_results[3];
+
+CC_TH_FUNC_RET thread_func_cond_timedwait(void *arg) {
+    struct timespec deadline;
+
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 50);
+    cc_mtx_lock(&g_test_cond_mtx);
+    g_test_cond_woken++;
+    g_test_cond_results[(intptr_t)arg] = cc_cond_timedwait(&g_test_cond, &g_test_cond_mtx, &deadline);
+    cc_mtx_unlock(&g_test_cond_mtx);
+    CC_TH_RETURN(0);
+}
+
+// Test cc_cond_timedwait expiring while still reacquiring the mutex
+void test_cc_cond_timedwait(void) {
+    cc_mtx mtx = CC_MTX_INITIALIZER;
+    cc_cond cond;
+    struct timespec deadline;
+    cc_th th[3];
+
+    cc_cond_init(&cond);
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+
+    cc_mtx_lock(&mtx);
+    TEST_ASSERT_EQUAL_INT(ETIMEDOUT, cc_cond_timedwait(&cond, &mtx, &deadline));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_mtx_trylock(&mtx));
+    cc_mtx_unlock(&mtx);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_cond_destroy(&cond));
+
+    // broadcast before the deadline, the mutex only comes back after it: every waiter was signalled
+    g_test_cond_woken = 0;
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_cond_timedwait, (void *)(intptr_t)i));
+    cc_mtx_lock(&g_test_cond_mtx);
+    while (3 != g_test_cond_woken) {
+        cc_mtx_unlock(&g_test_cond_mtx);
+#ifdef CC_POSIX
+        nanosleep((const struct timespec[]){{0, 1000000L}}, NULL);
+#elif defined(CC_WINDOWS)
+        Sleep(1);
+#endif
+        cc_mtx_lock(&g_test_cond_mtx);
+    }
+    cc_cond_broadcast(&g_test_cond);
+#ifdef CC_POSIX
+    nanosleep((const struct timespec[]){{0, 100000000L}}, NULL);
+#elif defined(CC_WINDOWS)
+    Sleep(100);
+#endif
+    cc_mtx_unlock(&g_test_cond_mtx);
+    for (int i = 0; i < 3; i++) {
+        cc_th_join(th[i], NULL);
+        TEST_ASSERT_EQUAL_INT(0, g_test_cond_results[i]);
+    }
+}
+
+
+// Shared semaphores for the producer/consumer test
+static cc_sem g_test_sem_items = CC_SEM_INITIALIZER(0);
+static cc_sem g_test_sem_done = CC_SEM_INITIALIZER(0);
+
+// Consumer taking single permits, then reporting completion in one batch
+CC_TH_FUNC_RET thread_func_sem_consumer(void *arg) {
+    int items = (int)(intptr_t)arg;
+    for (int i = 0; i < items; i++)
+        cc_sem_wait(&g_test_sem_items);
+    cc_sem_post_n(&g_test_sem_done, (uint32_t)items);
+    CC_TH_RETURN(0);
+}
+
+// Test cc_sem_trywait, cc_sem_post_n and cc_sem_getvalue
+void test_cc_sem_counts(void) {
+    cc_sem sem;
+    uint32_t value;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_sem_init(&sem, 2));
+    TEST_ASSERT_EQUAL_INT(0, cc_sem_trywait(&sem));
+    TEST_ASSERT_EQUAL_INT(0, cc_sem_trywait(&sem));
+    TEST_ASSERT_EQUAL_INT(EAGAIN, cc_sem_trywait(&sem));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_sem_post_n(&sem, 5));
+    TEST_ASSERT_EQUAL_INT(EAGAIN, cc_sem_trywait_n(&sem, 6));
+    TEST_ASSERT_EQUAL_INT(0, cc_sem_trywait_n(&sem, 4));
+    cc_sem_getvalue(&sem, &value);
+    TEST_ASSERT_EQUAL_UINT32(1, value);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_sem_destroy(&sem));
+}
+
+// Test batch posting to blocked consumers and a batch wait
+void test_cc_sem_batch(void) {
+    cc_th th[4];
+
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_sem_consumer, (void *)(intptr_t)50));
+    for (int i = 0; i < 20; i++)
+        cc_sem_post_n(&g_test_sem_items, 10);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_sem_wait_n(&g_test_sem_done, 4 * 50));
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+    TEST_ASSERT_EQUAL_INT(EAGAIN, cc_sem_trywait(&g_test_sem_items));
+}
+
+// Test cc_sem_timedwait expiring
+void test_cc_sem_timedwait(void) {
+    cc_sem sem = CC_SEM_INITIALIZER(1);
+    struct timespec deadline;
+
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+    TEST_ASSERT_EQUAL_INT(0, cc_sem_timedwait(&sem, &deadline));
+    TEST_ASSERT_EQUAL_INT(ETIMEDOUT, cc_sem_timedwait(&sem, &deadline));
+}
+
+
+// Shared state for the barrier tests: every participant publishes its phase
+static cc_barrier g_test_bar;
+static uint32_t g_test_bar_phase[8];
+static uint32_t g_test_bar_errors = 0;
+static uint32_t g_test_bar_serial = 0;
+
+// Thread function running several phases separated by barriers
+CC_TH_FUNC_RET thread_func_barrier(void *arg) {
+    int id = (int)(intptr_t)arg;
+    for (uint32_t phase = 1; phase <= 50; phase++) {
+        cc_atomic_store_u32(&g_test_bar_phase[id], phase, CC_MO_RELAXED);
+        if (CC_BARRIER_SERIAL_THREAD == cc_barrier_wait(&g_test_bar, (uint32_t)id))
+            cc_atomic_fetch_add_u32(&g_test_bar_serial, 1, CC_MO_RELAXED);
+        for (int i = 0; i < (int)g_test_bar.count; i++)
+            if (cc_atomic_load_u32(&g_test_bar_phase[i], CC_MO_RELAXED) < phase)
+                cc_atomic_fetch_add_u32(&g_test_bar_errors, 1, CC_MO_RELAXED);
+        cc_barrier_wait(&g_test_bar, (uint32_t)id);
+    }
+    CC_TH_RETURN(0);
+}
+
+static void run_barrier_test(uint32_t count, int algorithm) {
+    cc_th th[8];
+
+    TEST_ASSERT_EQUAL_INT(0, cc_barrier_init(&g_test_bar, count, algorithm));
+    g_test_bar_errors = 0;
+    g_test_bar_serial = 0;
+    for (int i = 0; i < 8; i++) g_test_bar_phase[i] = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_barrier, (void *)(intptr_t)i));
+    for (uint32_t i = 0; i < count; i++)
+        cc_th_join(th[i], NULL);
+
+    TEST_ASSERT_EQUAL_UINT32(0, g_test_bar_errors);
+    TEST_ASSERT_EQUAL_UINT32(50, g_test_bar_serial);
+    TEST_ASSERT_EQUAL_INT(0, cc_barrier_destroy(&g_test_bar));
+}
+
+// Test the centralized sense-reversing barrier
+void test_cc_barrier_central(void) {
+    run_barrier_test(4, CC_BARRIER_CENTRAL);
+}
+
+// Test the dissemination barrier with a non power of two participant count
+void test_cc_barrier_dissemination(void) {
+    run_barrier_test(5, CC_BARRIER_DISSEMINATION);
+}
+
+
+// Shared state for the parking lot tests
+static cc_lock g_test_lock = CC_LOCK_INITIALIZER;
+static long g_test_lock_counter = 0;
+static cc_event g_test_event = CC_EVENT_INITIALIZER;
+static uint32_t g_test_event_woken = 0;
+
+// Thread function incrementing a shared counter under the one byte cc_lock
+CC_TH_FUNC_RET thread_func_lock(void *arg) {
+    int iterations = (int)(intptr_t)arg;
+    for (int i = 0; i < iterations; i++) {
+        cc_lock_acquire(&g_test_lock);
+        g_test_lock_counter++;
+        cc_lock_release(&g_test_lock);
+    }
+    CC_TH_RETURN(0);
+}
+
+// Thread function waiting for the shared event
+CC_TH_FUNC_RET thread_func_event(void *arg) {
+    (void)arg;
+    cc_event_wait(&g_test_event);
+    cc_atomic_fetch_add_u32(&g_test_event_woken, 1, CC_MO_RELAXED);
+    CC_TH_RETURN(0);
+}
+
+// Test cc_park validation, timeout and cc_unpark_one on an empty queue
+void test_cc_park(void) {
+    uint8_t byte = 1;
+    struct timespec deadline;
+
+    TEST_ASSERT_EQUAL_INT(EAGAIN, cc_park(&byte, cc__park_validate_byte, &(cc__park_byte){ &byte, 0 }, NULL));
+
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+    TEST_ASSERT_EQUAL_INT(ETIMEDOUT, cc_park(&byte, NULL, NULL, &deadline));
+    TEST_ASSERT_EQUAL_INT(0, cc_unpark_one(&byte, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_unpark_all(&byte));
+}
+
+// Test the one byte cc_lock under contention
+void test_cc_lock(void) {
+    cc_th th[4];
+    int iterations = 20000;
+
+    TEST_ASSERT_EQUAL_INT(1, (int)sizeof(cc_lock));
+    TEST_ASSERT_EQUAL_INT(0, cc_lock_tryacquire(&g_test_lock));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_lock_tryacquire(&g_test_lock));
+    cc_lock_release(&g_test_lock);
+
+    g_test_lock_counter = 0;
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_lock, (void *)(intptr_t)iterations));
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+
+    TEST_ASSERT_EQUAL_INT(4 * iterations, (int)g_test_lock_counter);
+    TEST_ASSERT_EQUAL_INT(0, (int)g_test_lock.state);
+}
+
+// Test the one byte cc_event releasing parked waiters
+void test_cc_event(void) {
+    cc_th th[3];
+    struct timespec deadline;
+
+    TEST_ASSERT_EQUAL_INT(1, (int)sizeof(cc_event));
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+    TEST_ASSERT_EQUAL_INT(ETIMEDOUT, cc_event_timedwait(&g_test_event, &deadline));
+
+    g_test_event_woken = 0;
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_event, NULL));
+#ifdef CC_POSIX
+    nanosleep((const struct timespec[]){{0, 10000000L}}, NULL);
+#elif defined(CC_WINDOWS)
+    Sleep(10);
+#endif
+    TEST_ASSERT_EQUAL_UINT32(0, g_test_event_woken);
+    cc_event_set(&g_test_event);
+    for (int i = 0; i < 3; i++)
+        cc_th_join(th[i], NULL);
+
+    TEST_ASSERT_EQUAL_UINT32(3, g_test_event_woken);
+    TEST_ASSERT_TRUE(cc_event_is_set(&g_test_event));
+    cc_event_reset(&g_test_event);
+    TEST_ASSERT_FALSE(cc_event_is_set(&g_test_event));
+}
+
+
+// Shared state for the queue lock tests
+static cc_mcs_lock g_test_mcs = CC_MCS_LOCK_INITIALIZER;
+static cc_clh_lock g_test_clh;
+static long g_test_qlock_counter = 0;
+
+// Thread function incrementing the shared counter under the MCS lock
+CC_TH_FUNC_RET thread_func_mcs(void *arg) {
+    int iterations = (int)(intptr_t)arg;
+    for (int i = 0; i < iterations; i++) {
+        cc_mcs_lock_acquire(&g_test_mcs);
+        g_test_qlock_counter++;
+        cc_mcs_lock_release(&g_test_mcs);
+    }
+    cc_qlock_cleanup();
+    CC_TH_RETURN(0);
+}
+
+// Thread function incrementing the shared counter under the CLH lock
+CC_TH_FUNC_RET thread_func_clh(void *arg) {
+    int iterations = (int)(intptr_t)arg;
+    for (int i = 0; i < iterations; i++) {
+        cc_clh_lock_acquire(&g_test_clh);
+        g_test_qlock_counter++;
+        cc_clh_lock_release(&g_test_clh);
+    }
+    cc_qlock_cleanup();
+    CC_TH_RETURN(0);
+}
+
+static void run_qlock_test(cc_th_func th_func) {
+    cc_th th[4];
+    int iterations = 10000;
+
+    g_test_qlock_counter = 0;
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, th_func, (void *)(intptr_t)iterations));
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+    TEST_ASSERT_EQUAL_INT(4 * iterations, (int)g_test_qlock_counter);
+}
+
+// Test the MCS lock: trylock semantics and mutual exclusion
+void test_cc_mcs_lock(void) {
+    TEST_ASSERT_EQUAL_INT(0, cc_mcs_lock_tryacquire(&g_test_mcs));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_mcs_lock_tryacquire(&g_test_mcs));
+    TEST_ASSERT_EQUAL_INT(EBUSY, cc_mcs_lock_destroy(&g_test_mcs));
+    cc_mcs_lock_release(&g_test_mcs);
+
+    run_qlock_test(thread_func_mcs);
+    TEST_ASSERT_EQUAL_INT(0, cc_mcs_lock_destroy(&g_test_mcs));
+    cc_qlock_cleanup();
+}
+
+// Test the CLH lock mutual exclusion
+void test_cc_clh_lock(void) {
+    TEST_ASSERT_EQUAL_INT(0, cc_clh_lock_init(&g_test_clh));
+    run_qlock_test(thread_func_clh);
+    TEST_ASSERT_EQUAL_INT(0, cc_clh_lock_destroy(&g_test_clh));
+}
+
+
+// Shared state for the cohort lock test
+static cc_cohort_lock g_test_cohort;
+static long g_test_cohort_counter = 0;
+
+// Thread function incrementing the shared counter under the cohort lock
+CC_TH_FUNC_RET thread_func_cohort(void *arg) {
+    int iterations = (int)(intptr_t)arg;
+    for (int i = 0; i < iterations; i++) {
+        cc_cohort_lock_acquire(&g_test_cohort);
+        g_test_cohort_counter++;
+        cc_cohort_lock_release(&g_test_cohort);
+    }
+    cc_qlock_cleanup();
+    CC_TH_RETURN(0);
+}
+
+// Test cc_cohort_lock topology discovery and mutual exclusion
+void test_cc_cohort_lock(void) {
+    cc_th th[4];
+    int iterations = 10000;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_cohort_lock_init(&g_test_cohort, 4));
+    TEST_ASSERT_TRUE(g_test_cohort.n_nodes >= 1);
+    TEST_ASSERT_TRUE(g_test_cohort.n_cpus >= 1);
+
+    g_test_cohort_counter = 0;
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_cohort, (void *)(intptr_t)iterations));
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+
+    TEST_ASSERT_EQUAL_INT(4 * iterations, (int)g_test_cohort_counter);
+    TEST_ASSERT_EQUAL_INT(0, cc_cohort_lock_destroy(&g_test_cohort));
+    cc_qlock_cleanup();
+}
+
+
+// Shared snapshot for the seqlock test: "b" and "c" are always derived from "a"
+typedef struct {
+    long a, b, c;
+    char tag[5];
+} test_snapshot;
+
+static cc_seqlock g_test_sl = CC_SEQLOCK_INITIALIZER;
+static test_snapshot g_test_snapshot;
+static uint32_t g_test_sl_torn = 0;
+
+// Thread function reading snapshots optimistically and checking their consistency
+CC_TH_FUNC_RET thread_func_seqlock_reader(void *arg) {
+    test_snapshot snap;
+    (void)arg;
+    for (int i = 0; i < 20000; i++) {
+        cc_seqlock_read(&g_test_sl, &snap, &g_test_snapshot, sizeof(snap));
+        if (snap.b != snap.a * 2 || snap.c != snap.a * 3 || snap.tag[0] != (char)('a' + snap.a % 26))
+            cc_atomic_fetch_add_u32(&g_test_sl_torn, 1, CC_MO_RELAXED);
+    }
+    CC_TH_RETURN(0);
+}
+
+// Test cc_seqlock_read_begin / cc_seqlock_read_retry around a write
+void test_cc_seqlock_retry(void) {
+    cc_seqlock sl;
+    uint32_t start;
+
+    cc_seqlock_init(&sl);
+    start = cc_seqlock_read_begin(&sl);
+    TEST_ASSERT_FALSE(cc_seqlock_read_retry(&sl, start));
+
+    cc_seqlock_write_begin(&sl);
+    cc_seqlock_write_end(&sl);
+    TEST_ASSERT_TRUE(cc_seqlock_read_retry(&sl, start));
+    TEST_ASSERT_EQUAL_UINT32(start + 2, cc_seqlock_read_begin(&sl));
+}
+
+// Thread function waiting in cc_seqlock_read_begin behind a long write
+static uint32_t g_test_sl_seen = 0;
+
+CC_TH_FUNC_RET thread_func_seqlock_wait(void *arg) {
+    (void)arg;
+    cc_atomic_store_u32(&g_test_sl_seen, cc_seqlock_read_begin(&g_test_sl), CC_MO_RELAXED);
+    CC_TH_RETURN(0);
+}
+
+// Test a reader outlasting the spin behind a long write, without ever writing to the seqlock
+void test_cc_seqlock_wait(void) {
+    cc_th th;
+    uint32_t start = cc_seqlock_read_begin(&g_test_sl);
+
+    TEST_ASSERT_EQUAL_INT(4, (int)sizeof(cc_seqlock));  /* no reader-written state */
+    cc_seqlock_write_begin(&g_test_sl);
+    TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th, NULL, thread_func_seqlock_wait, NULL));
+#ifdef CC_POSIX
+    nanosleep((const struct timespec[]){{0, 20000000L}}, NULL);
+#elif defined(CC_WINDOWS)
+    Sleep(20);
+#endif
+    TEST_ASSERT_EQUAL_UINT32(start + 1, g_test_sl.seq);
+    cc_seqlock_write_end(&g_test_sl);
+    cc_th_join(th, NULL);
+    TEST_ASSERT_EQUAL_UINT32(start + 2, g_test_sl_seen);
+}
+
+// Test readers never observing a torn snapshot while a writer updates it
+void test_cc_seqlock_snapshot(void) {
+    cc_th th[3];
+    test_snapshot snap = { 0, 0, 0, "a" };
+
+    g_test_snapshot = snap;
+    g_test_sl_torn = 0;
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_seqlock_reader, NULL));
+    for (long v = 1; v <= 5000; v++) {
+        snap.a = v;
+        snap.b = v * 2;
+        snap.c = v * 3;
+        snap.tag[0] = (char)('a' + v % 26);
+        cc_seqlock_write(&g_test_sl, &g_test_snapshot, &snap, sizeof(snap));
+    }
+    for (int i = 0; i < 3; i++)
+        cc_th_join(th[i], NULL);
+
+    TEST_ASSERT_EQUAL_UINT32(0, g_test_sl_torn);
+}
+
+
+// Shared counter for the atomics test
+static uint64_t g_test_atomic_counter = 0;
+
+// Thread function incrementing the shared counter with relaxed fetch_add
+CC_TH_FUNC_RET thread_func_atomic(void *arg) {
+    int iterations = (int)(intptr_t)arg;
+    for (int i = 0; i < iterations; i++)
+        cc_atomic_fetch_add_u64(&g_test_atomic_counter, 1, CC_MO_RELAXED);
+    CC_TH_RETURN(0);
+}
+
+// Test the typed cc_atomic_* operations
+void test_cc_atomic_ops(void) {
+    uint8_t b = 1;
+    uint32_t u = 5, expected32 = 4;
+    uint64_t w = 0xFFFFFFFFULL, expected64 = 0xFFFFFFFFULL;
+    int x = 0, y = 0;
+    void *p = &x, *p_expected = &y;
+
+    cc_atomic_store_u8(&b, 2, CC_MO_RELEASE);
+    TEST_ASSERT_EQUAL_UINT8(2, cc_atomic_exchange_u8(&b, 3, CC_MO_ACQ_REL));
+    TEST_ASSERT_EQUAL_UINT8(3, cc_atomic_load_u8(&b, CC_MO_ACQUIRE));
+
+    TEST_ASSERT_FALSE(cc_atomic_cas_u32(&u, &expected32, 6, CC_MO_SEQ_CST, CC_MO_RELAXED));
+    TEST_ASSERT_EQUAL_UINT32(5, expected32);
+    TEST_ASSERT_TRUE(cc_atomic_cas_u32(&u, &expected32, 6, CC_MO_SEQ_CST, CC_MO_RELAXED));
+    TEST_ASSERT_EQUAL_UINT32(6, cc_atomic_fetch_add_u32(&u, 4, CC_MO_RELAXED));
+    TEST_ASSERT_EQUAL_UINT32(10, cc_atomic_fetch_sub_u32(&u, 1, CC_MO_RELAXED));
+    TEST_ASSERT_EQUAL_UINT32(9, cc_atomic_exchange_u32(&u, 0, CC_MO_ACQ_REL));
+
+    TEST_ASSERT_TRUE(cc_atomic_cas_u64(&w, &expected64, 0x100000000ULL, CC_MO_ACQ_REL, CC_MO_ACQUIRE));
+    TEST_ASSERT_EQUAL_UINT64(0x100000000ULL, cc_atomic_fetch_add_u64(&w, 1, CC_MO_RELAXED));
+    TEST_ASSERT_EQUAL_UINT64(0x100000001ULL, cc_atomic_load_u64(&w, CC_MO_SEQ_CST));
+
+    TEST_ASSERT_FALSE(cc_atomic_cas_ptr(&p, &p_expected, &y, CC_MO_SEQ_CST, CC_MO_SEQ_CST));
+    TEST_ASSERT_EQUAL_PTR(&x, p_expected);
+    TEST_ASSERT_EQUAL_PTR(&x, cc_atomic_exchange_ptr(&p, &y, CC_MO_SEQ_CST));
+    TEST_ASSERT_EQUAL_PTR(&y, cc_atomic_load_ptr(&p, CC_MO_ACQUIRE));
+    cc_atomic_fence(CC_MO_SEQ_CST);
+}
+
+// Test relaxed increments from several threads adding up
+void test_cc_atomic_counter(void) {
+    cc_th th[4];
+    int iterations = 50000;
+
+    g_test_atomic_counter = 0;
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th[i], NULL, thread_func_atomic, (void *)(intptr_t)iterations));
+    for (int i = 0; i < 4; i++)
+        cc_th_join(th[i], NULL);
+    TEST_ASSERT_EQUAL_UINT64(4 * iterations, cc_atomic_load_u64(&g_test_atomic_counter, CC_MO_RELAXED));
+}
+
+
+// Shared state for the pool tests
+static cc_pool g_test_pool;
+static uint32_t g_test_pool_count = 0;
+
+static void task_pool_count(void *arg) {
+    (void)arg;
+    cc_atomic_fetch_add_u32(&g_test_pool_count, 1, CC_MO_RELAXED);
+}
+
+// Spawns two subtasks until the depth runs out, counting the leaves
+static void task_pool_tree(void *arg) {
+    intptr_t depth = (intptr_t)arg;
+    if (0 == depth) {
+        cc_atomic_fetch_add_u32(&g_test_pool_count, 1, CC_MO_RELAXED);
+        return;
+    }
+    cc_pool_submit(&g_test_pool, task_pool_tree, (void *)(depth - 1));
+    cc_pool_submit(&g_test_pool, task_pool_tree, (void *)(depth - 1));
+}
+
+// Submits more tasks from a worker than its deque holds
+static void task_pool_fan_out(void *arg) {
+    for (intptr_t i = 0; i < (intptr_t)arg; i++)
+        cc_pool_submit(&g_test_pool, task_pool_count, NULL);
+}
+
+static int g_test_pool_wait_err = 0;
+
+static void task_pool_wait_inside(void *arg) {
+    (void)arg;
+    g_test_pool_wait_err = cc_pool_wait(&g_test_pool);
+}
+
+// Test many tasks submitted from outside the pool, waited for repeatedly
+void test_cc_pool_submit_wait(void) {
+    g_test_pool_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 4));
+    for (int round = 1; round <= 3; round++) {
+        for (int i = 0; i < 10000; i++)
+            TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_count, NULL));
+        TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+        TEST_ASSERT_EQUAL_UINT32(10000 * round, cc_atomic_load_u32(&g_test_pool_count, CC_MO_RELAXED));
+    }
+
+    // waiting from inside a task of the same pool would never return
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_wait_inside, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    TEST_ASSERT_EQUAL_INT(EDEADLK, g_test_pool_wait_err);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_shutdown(&g_test_pool));
+    TEST_ASSERT_EQUAL_INT(-1, cc_pool_submit(&g_test_pool, task_pool_count, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Test spawning from the workers: own deque pushes, steals and the overflow to the shared queue
+void test_cc_pool_recursive(void) {
+    g_test_pool_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 0));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_tree, (void *)(intptr_t)16));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    TEST_ASSERT_EQUAL_UINT32(1U << 16, g_test_pool_count);
+
+    g_test_pool_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_fan_out, (void *)(intptr_t)(3 * CC_POOL_DEQUE_SIZE)));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    TEST_ASSERT_EQUAL_UINT32(3 * CC_POOL_DEQUE_SIZE, g_test_pool_count);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Slow task recording the highest number of live workers it saw
+static uint32_t g_test_pool_live_max = 0;
+
+static void task_pool_slow(void *arg) {
+    uint32_t live = cc_atomic_load_u32(&g_test_pool.n_live, CC_MO_RELAXED);
+    uint32_t seen = cc_atomic_load_u32(&g_test_pool_live_max, CC_MO_RELAXED);
+    (void)arg;
+    while (live > seen && !cc_atomic_cas_u32(&g_test_pool_live_max, &seen, live, CC_MO_RELAXED, CC_MO_RELAXED)) {}
+    nanosleep((const struct timespec[]){{0, 1000000L}}, NULL);
+    cc_atomic_fetch_add_u32(&g_test_pool_count, 1, CC_MO_RELAXED);
+}
+
+// Polls until the pool is down to "live" workers, up to 2 seconds
+static int wait_pool_live(uint32_t live) {
+    for (int i = 0; i < 2000 && cc_atomic_load_u32(&g_test_pool.n_live, CC_MO_ACQUIRE) != live; i++)
+        nanosleep((const struct timespec[]){{0, 1000000L}}, NULL);
+    return cc_atomic_load_u32(&g_test_pool.n_live, CC_MO_ACQUIRE) == live;
+}
+
+// Test an elastic pool grows under a backlog, shrinks back to its minimum when idle and grows again
+void test_cc_pool_elastic(void) {
+    g_test_pool_count = 0;
+    g_test_pool_live_max = 0;
+    TEST_ASSERT_EQUAL_INT(-1, cc_pool_init_elastic(&g_test_pool, 5, 4, 10, 0));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init_elastic(&g_test_pool, 1, 4, 10, 64 * 1024));
+    TEST_ASSERT_EQUAL_UINT32(1, g_test_pool.n_live);
+    for (int i = 0; i < 200; i++) TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_slow, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    TEST_ASSERT_EQUAL_UINT32(200, g_test_pool_count);
+    TEST_ASSERT_TRUE(g_test_pool_live_max > 1);
+    TEST_ASSERT_TRUE(g_test_pool_live_max <= 4);
+    TEST_ASSERT_TRUE(wait_pool_live(1));
+
+    // retired slots are joined and reused
+    g_test_pool_count = 0;
+    for (int i = 0; i < 100; i++) TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_slow, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    TEST_ASSERT_EQUAL_UINT32(100, g_test_pool_count);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+
+    // no resident worker at all
+    g_test_pool_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init_elastic(&g_test_pool, 0, 2, 1, 0));
+    for (int round = 0; round < 3; round++) {
+        TEST_ASSERT_TRUE(wait_pool_live(0));
+        TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_count, NULL));
+        TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, g_test_pool_count);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Polls until "count" tasks ran, up to 2 seconds
+static int wait_pool_count(uint32_t count) {
+    for (int i = 0; i < 20000 && cc_atomic_load_u32(&g_test_pool_count, CC_MO_ACQUIRE) != count; i++)
+        nanosleep((const struct timespec[]){{0, 100000L}}, NULL);
+    return cc_atomic_load_u32(&g_test_pool_count, CC_MO_ACQUIRE) == count;
+}
+
+// Test submits racing a single elastic worker as it retires are never stranded
+void test_cc_pool_elastic_retire_race(void) {
+    uint32_t count = 0;
+
+    g_test_pool_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init_elastic(&g_test_pool, 0, 1, 1, 0));
+    for (uint32_t round = 0; round < 300; round++) {
+        // a burst fills the worker's task cache, so it takes a while to exit once idle
+        for (int i = 0; i < 64; i++) TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_count, NULL));
+        count += 64;
+        TEST_ASSERT_TRUE(wait_pool_count(count));
+        // submit right as the worker gives up its live count, with a varying delay to sweep its exit path
+        while (0 != cc_atomic_load_u32(&g_test_pool.n_live, CC_MO_ACQUIRE)) {}
+        for (volatile uint32_t spin = 0; spin < (round % 30) * 50; spin++) {}
+        TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_count, NULL));
+        TEST_ASSERT_TRUE(wait_pool_count(++count));
+    }
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Recursive fibonacci forking one branch into a task group, the waiting task helps instead of blocking
+typedef struct {
+    int n;
+    long result;
+} test_fib;
+
+static void task_group_fib(void *arg) {
+    test_fib *p_fib = (test_fib *)arg;
+    test_fib left, right;
+    cc_task_group group;
+
+    if (p_fib->n < 2) {
+        p_fib->result = p_fib->n;
+        return;
+    }
+    left.n = p_fib->n - 1;
+    right.n = p_fib->n - 2;
+    cc_task_group_init(&group, &g_test_pool);
+    cc_task_group_run(&group, task_group_fib, &left);
+    task_group_fib(&right);
+    cc_task_group_wait(&group);
+    cc_task_group_destroy(&group);
+    p_fib->result = left.result + right.result;
+}
+
+// Test recursive fork-join deeper than the number of workers, waited for from outside and reused
+void test_cc_task_group_fork_join(void) {
+    cc_task_group group;
+    test_fib fib;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 2));
+    TEST_ASSERT_EQUAL_INT(0, cc_task_group_init(&group, &g_test_pool));
+    for (int round = 0; round < 2; round++) {
+        fib.n = 22;
+        fib.result = 0;
+        TEST_ASSERT_EQUAL_INT(0, cc_task_group_run(&group, task_group_fib, &fib));
+        TEST_ASSERT_EQUAL_INT(0, cc_task_group_wait(&group));
+        TEST_ASSERT_EQUAL_INT(17711, (int)fib.result);
+    }
+    TEST_ASSERT_EQUAL_INT(0, cc_task_group_destroy(&group));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Test a group waiting only for its own tasks while others are still queued
+void test_cc_task_group_scope(void) {
+    cc_task_group group;
+
+    g_test_pool_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 1));
+    TEST_ASSERT_EQUAL_INT(0, cc_task_group_init(&group, &g_test_pool));
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_EQUAL_INT(0, cc_task_group_run(&group, task_pool_count, NULL));
+        TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pool_count, NULL));
+    }
+    TEST_ASSERT_EQUAL_INT(0, cc_task_group_wait(&group));
+    TEST_ASSERT_EQUAL_INT(0, cc_task_group_destroy(&group));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    TEST_ASSERT_EQUAL_UINT32(2000, g_test_pool_count);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Shared state for the future tests
+static cc_promise g_test_promise;
+
+CC_TH_FUNC_RET thread_func_promise(void *arg) {
+    cc_promise_set_value(&g_test_promise, arg);
+    CC_TH_RETURN(0);
+}
+
+// Continuation adding its argument to the integer carried by the source future
+static int cont_future_add(cc_future *p_src, void *arg, void **p_result) {
+    void *value = NULL;  /* left unset when the source failed */
+    int error = cc_future_get(p_src, &value);
+    *p_result = (void *)((intptr_t)value + (intptr_t)arg);
+    return error;
+}
+
+// Test a promise fulfilled by another thread, timeouts, double sets and errors
+void test_cc_future_promise(void) {
+    cc_future future, failed;
+    cc_promise promise;
+    struct timespec deadline;
+    cc_th th;
+    void *value = NULL;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_promise_init(&g_test_promise, &future));
+    cc_time_monotonic(&deadline);
+    cc_time_add_ms(&deadline, 20);
+    TEST_ASSERT_EQUAL_INT(ETIMEDOUT, cc_future_timedwait(&future, &deadline));
+    TEST_ASSERT_FALSE(cc_future_is_ready(&future));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_th_create(&th, NULL, thread_func_promise, (void *)(intptr_t)42));
+    TEST_ASSERT_EQUAL_INT(0, cc_future_get(&future, &value));
+    TEST_ASSERT_EQUAL_INT(42, (int)(intptr_t)value);
+    cc_th_join(th, NULL);
+    TEST_ASSERT_TRUE(cc_future_is_ready(&future));
+    TEST_ASSERT_EQUAL_INT(-1, cc_promise_set_value(&g_test_promise, NULL));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_promise_init(&promise, &failed));
+    TEST_ASSERT_EQUAL_INT(0, cc_promise_set_error(&promise, EINVAL));
+    TEST_ASSERT_EQUAL_INT(EINVAL, cc_future_get(&failed, NULL));
+}
+
+// Test continuation chains (inline and on a pool) and the when_all / when_any combinators
+void test_cc_future_compose(void) {
+    cc_promise promises[3];
+    cc_future sources[3], chain[3], all, any;
+    cc_future *p_sources[3] = { &sources[0], &sources[1], &sources[2] };
+    cc_continuation conts[3], all_conts[3], any_conts[3];
+    cc_executor exec;
+    void *value = NULL;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 2));
+    exec = cc_pool_executor(&g_test_pool);
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_promise_init(&promises[i], &sources[i]));
+
+    // sources[0] -> +1 on the pool -> +10 inline -> +100 on the pool
+    TEST_ASSERT_EQUAL_INT(0, cc_future_then(&sources[0], &conts[0], cont_future_add, (void *)(intptr_t)1, &exec, &chain[0]));
+    TEST_ASSERT_EQUAL_INT(0, cc_future_then(&chain[0], &conts[1], cont_future_add, (void *)(intptr_t)10, NULL, &chain[1]));
+    TEST_ASSERT_EQUAL_INT(0, cc_future_then(&chain[1], &conts[2], cont_future_add, (void *)(intptr_t)100, &exec, &chain[2]));
+    TEST_ASSERT_EQUAL_INT(0, cc_future_when_all(&all, p_sources, 3, all_conts));
+    TEST_ASSERT_EQUAL_INT(0, cc_future_when_any(&any, p_sources, 3, any_conts));
+    TEST_ASSERT_FALSE(cc_future_is_ready(&any));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_promise_set_value(&promises[2], (void *)(intptr_t)7));
+    TEST_ASSERT_EQUAL_INT(0, cc_future_get(&any, &value));
+    TEST_ASSERT_EQUAL_PTR(&sources[2], value);
+    TEST_ASSERT_FALSE(cc_future_is_ready(&all));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_promise_set_value(&promises[0], (void *)(intptr_t)1000));
+    TEST_ASSERT_EQUAL_INT(0, cc_future_get(&chain[2], &value));
+    TEST_ASSERT_EQUAL_INT(1111, (int)(intptr_t)value);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_promise_set_error(&promises[1], ECANCELED));
+    TEST_ASSERT_EQUAL_INT(ECANCELED, cc_future_get(&all, NULL));
+
+    // registering on a ready future runs the continuation right away
+    TEST_ASSERT_EQUAL_INT(0, cc_future_then(&chain[2], &conts[0], cont_future_add, (void *)(intptr_t)1, NULL, &chain[0]));
+    TEST_ASSERT_TRUE(cc_future_is_ready(&chain[0]));
+    TEST_ASSERT_EQUAL_INT(0, cc_future_get(&chain[0], &value));
+    TEST_ASSERT_EQUAL_INT(1112, (int)(intptr_t)value);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Shared state for the parallel loop tests: every index must be visited exactly once
+#define TEST_PFOR_SIZE 100000
+static uint8_t g_test_pfor_hits[TEST_PFOR_SIZE];
+static uint64_t g_test_pfor_sum = 0;
+
+static void body_pfor_mark(size_t begin, size_t end, void *arg) {
+    uint64_t sum = 0;
+    (void)arg;
+    for (size_t i = begin; i < end; i++) {
+        g_test_pfor_hits[i]++;
+        sum += i;
+    }
+    cc_atomic_fetch_add_u64(&g_test_pfor_sum, sum, CC_MO_RELAXED);
+}
+
+static int check_pfor_hits(size_t begin, size_t end) {
+    for (size_t i = 0; i < TEST_PFOR_SIZE; i++) {
+        if (g_test_pfor_hits[i] != ((i >= begin && i < end) ? 1 : 0)) return 0;
+    }
+    return 1;
+}
+
+// Marks indexes counted down from SIZE_MAX, any index below that range is only counted
+static void body_pfor_mark_top(size_t begin, size_t end, void *arg) {
+    (void)arg;
+    for (size_t i = begin; i < end; i++) {
+        if (i >= SIZE_MAX - TEST_PFOR_SIZE) g_test_pfor_hits[i - (SIZE_MAX - TEST_PFOR_SIZE)]++;
+        else cc_atomic_fetch_add_u64(&g_test_pfor_sum, 1, CC_MO_RELAXED);
+    }
+}
+
+// Parallel loop started from inside a pool task
+static void task_pfor_nested(void *arg) {
+    (void)arg;
+    cc_parallel_for(&g_test_pool, 0, TEST_PFOR_SIZE, CC_PARALLEL_DYNAMIC, 64, body_pfor_mark, NULL);
+}
+
+// Test every schedule covering the range exactly once
+void test_cc_parallel_for_schedules(void) {
+    int schedules[4] = { CC_PARALLEL_STATIC, CC_PARALLEL_DYNAMIC, CC_PARALLEL_GUIDED, CC_PARALLEL_AUTO };
+    uint64_t expected = 0;
+
+    for (size_t i = 10; i < TEST_PFOR_SIZE - 3; i++) expected += i;
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 3));
+    for (int s = 0; s < 4; s++) {
+        memset(g_test_pfor_hits, 0, sizeof(g_test_pfor_hits));
+        g_test_pfor_sum = 0;
+        TEST_ASSERT_EQUAL_INT(0, cc_parallel_for(&g_test_pool, 10, TEST_PFOR_SIZE - 3, schedules[s], 100, body_pfor_mark, NULL));
+        TEST_ASSERT_TRUE(check_pfor_hits(10, TEST_PFOR_SIZE - 3));
+        TEST_ASSERT_EQUAL_UINT64(expected, g_test_pfor_sum);
+    }
+
+    // claims past the end of a range ending at SIZE_MAX must not wrap around to its start
+    for (int s = 0; s < 4; s++) {
+        memset(g_test_pfor_hits, 0, sizeof(g_test_pfor_hits));
+        g_test_pfor_sum = 0;
+        TEST_ASSERT_EQUAL_INT(0, cc_parallel_for(&g_test_pool, SIZE_MAX - TEST_PFOR_SIZE, SIZE_MAX, schedules[s], 100, body_pfor_mark_top, NULL));
+        TEST_ASSERT_TRUE(check_pfor_hits(0, TEST_PFOR_SIZE));
+        TEST_ASSERT_EQUAL_UINT64(0, g_test_pfor_sum);
+    }
+
+    // grain larger than the range runs inline
+    memset(g_test_pfor_hits, 0, sizeof(g_test_pfor_hits));
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_for(&g_test_pool, 5, 9, CC_PARALLEL_STATIC, 16, body_pfor_mark, NULL));
+    TEST_ASSERT_TRUE(check_pfor_hits(5, 9));
+
+    memset(g_test_pfor_hits, 0, sizeof(g_test_pfor_hits));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_pfor_nested, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_wait(&g_test_pool));
+    TEST_ASSERT_TRUE(check_pfor_hits(0, TEST_PFOR_SIZE));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_for(&g_test_pool, 7, 7, CC_PARALLEL_AUTO, 0, body_pfor_mark, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, cc_parallel_for(&g_test_pool, 8, 7, CC_PARALLEL_AUTO, 0, body_pfor_mark, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, cc_parallel_for(&g_test_pool, 0, 7, 42, 0, body_pfor_mark, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Affine maps x -> a * x + b (mod 2^32) composed left to right: associative but not commutative
+typedef struct {
+    uint32_t a;
+    uint32_t b;
+} test_affine;
+
+static void combine_affine(void *p_acc, const void *p_other, void *arg) {
+    test_affine *p_f = (test_affine *)p_acc;
+    const test_affine *p_g = (const test_affine *)p_other;
+    (void)arg;
+    p_f->b = p_g->a * p_f->b + p_g->b;
+    p_f->a = p_g->a * p_f->a;
+}
+
+static void map_affine(size_t first, size_t last, void *p_acc, void *arg) {
+    test_affine f;
+    for (size_t i = first; i < last; i++) {
+        f.a = (uint32_t)(i % 7) + 1;
+        f.b = (uint32_t)i;
+        combine_affine(p_acc, &f, arg);
+    }
+}
+
+static void map_sum_squares(size_t first, size_t last, void *p_acc, void *arg) {
+    uint64_t sum = 0;
+    (void)arg;
+    for (size_t i = first; i < last; i++) sum += (uint64_t)i * i;
+    *(uint64_t *)p_acc += sum;
+}
+
+static void combine_sum_u64(void *p_acc, const void *p_other, void *arg) {
+    (void)arg;
+    *(uint64_t *)p_acc += *(const uint64_t *)p_other;
+}
+
+static void combine_add_u32(void *p_acc, const void *p_item, void *arg) {
+    (void)arg;
+    *(uint32_t *)p_acc += *(const uint32_t *)p_item;
+}
+
+// Test reductions against their sequential results, including a non-commutative one
+void test_cc_parallel_reduce(void) {
+    test_affine identity = { 1, 0 }, expected = { 1, 0 }, result = { 0, 0 };
+    uint64_t zero = 0, sum = 0, expected_sum = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 3));
+    for (size_t i = 3; i < 100000; i++) expected_sum += (uint64_t)i * i;
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_reduce(&g_test_pool, 3, 100000, 0, &sum, sizeof(sum), &zero, map_sum_squares, combine_sum_u64, NULL));
+    TEST_ASSERT_EQUAL_UINT64(expected_sum, sum);
+
+    map_affine(0, 50000, &expected, NULL);
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_reduce(&g_test_pool, 0, 50000, 100, &result, sizeof(result), &identity, map_affine, combine_affine, NULL));
+    TEST_ASSERT_EQUAL_UINT32(expected.a, result.a);
+    TEST_ASSERT_EQUAL_UINT32(expected.b, result.b);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_reduce(&g_test_pool, 9, 9, 0, &result, sizeof(result), &identity, map_affine, combine_affine, NULL));
+    TEST_ASSERT_EQUAL_UINT32(1, result.a);
+    TEST_ASSERT_EQUAL_UINT32(0, result.b);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Test inclusive, exclusive and in-place scans against sequential prefix sums
+void test_cc_parallel_scan(void) {
+    size_t n = 100003;
+    uint32_t zero = 0, acc;
+    uint32_t *p_in = (uint32_t *)malloc(n * sizeof(uint32_t));
+    uint32_t *p_out = (uint32_t *)malloc(n * sizeof(uint32_t));
+    int ok = 1;
+
+    TEST_ASSERT_NOT_NULL(p_in);
+    TEST_ASSERT_NOT_NULL(p_out);
+    for (size_t i = 0; i < n; i++) p_in[i] = (uint32_t)(i * 2654435761U >> 20);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 3));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_scan(&g_test_pool, p_in, p_out, n, sizeof(uint32_t), 0, &zero, combine_add_u32, CC_SCAN_INCLUSIVE, NULL));
+    acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        acc += p_in[i];
+        if (p_out[i] != acc) ok = 0;
+    }
+    TEST_ASSERT_TRUE(ok);
+
+    // exclusive, in place over the inclusive prefix sums
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_scan(&g_test_pool, p_out, p_out, n, sizeof(uint32_t), 1000, &zero, combine_add_u32, CC_SCAN_EXCLUSIVE, NULL));
+    acc = 0;
+    for (uint32_t i = 0, inclusive = 0; i < n; i++) {
+        if (p_out[i] != acc) ok = 0;
+        inclusive += p_in[i];
+        acc += inclusive;
+    }
+    TEST_ASSERT_TRUE(ok);
+
+    TEST_ASSERT_EQUAL_INT(-1, cc_parallel_scan(&g_test_pool, p_in, p_out, n, sizeof(uint32_t), 0, &zero, combine_add_u32, 7, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+    free(p_in);
+    free(p_out);
+}
+
+// Records for the sort tests, "seq" is the original position and checks stability
+typedef struct {
+    uint64_t key;
+    uint32_t seq;
+} test_record;
+
+static int compare_record(const void *p_a, const void *p_b) {
+    uint64_t a = ((const test_record *)p_a)->key, b = ((const test_record *)p_b)->key;
+    return (a > b) - (a < b);
+}
+
+static uint64_t key_record(const void *p_item) {
+    return ((const test_record *)p_item)->key;
+}
+
+// Fills records with pseudo random keys below "range" (0 for the full 64 bits)
+static void fill_records(test_record *p_records, size_t n, uint64_t range) {
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        p_records[i].key = range ? x % range : x;
+        p_records[i].seq = (uint32_t)i;
+    }
+}
+
+// Sorted by key, a permutation of the input and, when "stable", equal keys keep their order
+static int check_records(const test_record *p_records, size_t n, int stable) {
+    uint8_t *p_seen = (uint8_t *)calloc(n, 1);
+    int ok = (NULL != p_seen);
+    for (size_t i = 0; ok && i < n; i++) {
+        if (p_records[i].seq >= n || p_seen[p_records[i].seq]++) ok = 0;
+        if (i > 0 && p_records[i - 1].key > p_records[i].key) ok = 0;
+        if (stable && i > 0 && p_records[i - 1].key == p_records[i].key && p_records[i - 1].seq > p_records[i].seq) ok = 0;
+    }
+    free(p_seen);
+    return ok;
+}
+
+// Test the sample sort on random, duplicate heavy, sorted and small inputs
+void test_cc_parallel_sort(void) {
+    size_t n = 200003;
+    test_record *p_records = (test_record *)malloc(n * sizeof(test_record));
+
+    TEST_ASSERT_NOT_NULL(p_records);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 3));
+    fill_records(p_records, n, 0);
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_sort(&g_test_pool, p_records, n, sizeof(test_record), compare_record));
+    TEST_ASSERT_TRUE(check_records(p_records, n, 0));
+
+    // already sorted input stays sorted
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_sort(&g_test_pool, p_records, n, sizeof(test_record), compare_record));
+    TEST_ASSERT_TRUE(check_records(p_records, n, 0));
+
+    fill_records(p_records, n, 5);
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_sort(&g_test_pool, p_records, n, sizeof(test_record), compare_record));
+    TEST_ASSERT_TRUE(check_records(p_records, n, 0));
+
+    fill_records(p_records, 100, 0);
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_sort(&g_test_pool, p_records, 100, sizeof(test_record), compare_record));
+    TEST_ASSERT_TRUE(check_records(p_records, 100, 0));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_sort(&g_test_pool, NULL, 0, sizeof(test_record), compare_record));
+    TEST_ASSERT_EQUAL_INT(-1, cc_parallel_sort(&g_test_pool, p_records, n, 0, compare_record));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+    free(p_records);
+}
+
+// Test the radix sort is stable on full width and narrow keys
+void test_cc_parallel_radix_sort(void) {
+    size_t n = 200003;
+    test_record *p_records = (test_record *)malloc(n * sizeof(test_record));
+
+    TEST_ASSERT_NOT_NULL(p_records);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 3));
+    fill_records(p_records, n, 0);
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_radix_sort(&g_test_pool, p_records, n, sizeof(test_record), key_record));
+    TEST_ASSERT_TRUE(check_records(p_records, n, 1));
+
+    // 1000 distinct keys: two passes, the rest are skipped
+    fill_records(p_records, n, 1000);
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_radix_sort(&g_test_pool, p_records, n, sizeof(test_record), key_record));
+    TEST_ASSERT_TRUE(check_records(p_records, n, 1));
+
+    fill_records(p_records, 1000, 256);
+    TEST_ASSERT_EQUAL_INT(0, cc_parallel_radix_sort(&g_test_pool, p_records, 1000, sizeof(test_record), key_record));
+    TEST_ASSERT_TRUE(check_records(p_records, 1000, 1));
+
+    TEST_ASSERT_EQUAL_INT(-1, cc_parallel_radix_sort(&g_test_pool, p_records, n, sizeof(test_record), NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+    free(p_records);
+}
+
+// Shared state for the priority pool tests: tasks log their argument in run order
+static cc_prio_pool g_test_prio_pool;
+static cc_event g_test_prio_gate;
+static int g_test_prio_order[16];
+static uint32_t g_test_prio_count = 0;
+
+static void task_prio_gate(void *arg) {
+    (void)arg;
+    cc_event_wait(&g_test_prio_gate);
+}
+
+static void task_prio_log(void *arg) {
+    g_test_prio_order[g_test_prio_count++] = (int)(intptr_t)arg;
+}
+
+// Blocks the single worker, queues the lowest band, then after "delay_ms" two tasks of the highest band
+static void run_prio_aging(uint32_t aging_ms, int delay_ms) {
+    cc_event_reset(&g_test_prio_gate);
+    g_test_prio_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_init(&g_test_prio_pool, 1, aging_ms));
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_submit(&g_test_prio_pool, CC_PRIO_HIGHEST, task_prio_gate, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_submit(&g_test_prio_pool, CC_PRIO_LOWEST, task_prio_log, (void *)(intptr_t)CC_PRIO_LOWEST));
+    nanosleep((const struct timespec[]){{0, delay_ms * 1000000L}}, NULL);
+    for (int i = 0; i < 2; i++)
+        TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_submit(&g_test_prio_pool, CC_PRIO_HIGHEST, task_prio_log, (void *)(intptr_t)CC_PRIO_HIGHEST));
+    cc_event_set(&g_test_prio_gate);
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_destroy(&g_test_prio_pool));
+    TEST_ASSERT_EQUAL_UINT32(3, g_test_prio_count);
+}
+
+// Test higher bands run first and FIFO order within a band
+void test_cc_prio_pool_bands(void) {
+    int expected[8] = { 0, 0, 1, 1, 2, 2, 3, 3 };
+    cc_executor exec;
+
+    cc_event_init(&g_test_prio_gate, 0);
+    g_test_prio_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_init(&g_test_prio_pool, 1, 0));
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_submit(&g_test_prio_pool, CC_PRIO_HIGHEST, task_prio_gate, NULL));
+    for (int band = CC_PRIO_LOWEST; band >= CC_PRIO_HIGHEST; band--) {
+        exec = cc_prio_pool_executor(&g_test_prio_pool, band);
+        TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_submit(&g_test_prio_pool, band, task_prio_log, (void *)(intptr_t)band));
+        TEST_ASSERT_EQUAL_INT(0, exec.submit(exec.ctx, task_prio_log, (void *)(intptr_t)band));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, cc_prio_pool_submit(&g_test_prio_pool, CC_PRIO_BANDS, task_prio_log, NULL));
+    cc_event_set(&g_test_prio_gate);
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_wait(&g_test_prio_pool));
+    TEST_ASSERT_EQUAL_UINT32(8, g_test_prio_count);
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, g_test_prio_order, 8);
+
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_shutdown(&g_test_prio_pool));
+    TEST_ASSERT_EQUAL_INT(-1, cc_prio_pool_submit(&g_test_prio_pool, CC_PRIO_HIGHEST, task_prio_log, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_prio_pool_destroy(&g_test_prio_pool));
+}
+
+// Test a long queued low band task overtakes fresh urgent ones only when aging is on
+void test_cc_prio_pool_aging(void) {
+    run_prio_aging(0, 20);
+    TEST_ASSERT_EQUAL_INT(CC_PRIO_LOWEST, g_test_prio_order[2]);
+    run_prio_aging(2, 20);
+    TEST_ASSERT_EQUAL_INT(CC_PRIO_LOWEST, g_test_prio_order[0]);
+}
+
+// Shared state for the timer tests
+#define TEST_TIMER_COUNT 1000
+static cc_timer_wheel g_test_wheel;
+static cc_timer g_test_timers[TEST_TIMER_COUNT];
+static uint64_t g_test_timer_due_ns[TEST_TIMER_COUNT];
+static uint32_t g_test_timer_fired = 0;
+static uint32_t g_test_timer_early = 0;
+
+static void timer_count(void *arg) {
+    size_t i = (size_t)(uintptr_t)arg;
+    if (cc__time_now_ns() < g_test_timer_due_ns[i]) cc_atomic_fetch_add_u32(&g_test_timer_early, 1, CC_MO_RELAXED);
+    cc_atomic_fetch_add_u32(&g_test_timer_fired, 1, CC_MO_RELEASE);
+}
+
+// Periodic callback stopping its own timer after 5 runs
+static void timer_periodic(void *arg) {
+    if (5 == cc_atomic_fetch_add_u32(&g_test_timer_fired, 1, CC_MO_RELEASE) + 1)
+        cc_atomic_store_u32(&g_test_timer_early, (uint32_t)cc_timer_cancel((cc_timer *)arg), CC_MO_RELAXED);
+}
+
+// One shot callback freeing its own timer, as a per connection timeout would with its connection
+static void timer_free_self(void *arg) {
+    free(arg);
+    cc_atomic_fetch_add_u32(&g_test_timer_fired, 1, CC_MO_RELEASE);
+}
+
+// Periodic callback slow enough to be caught running by "cc_timer_cancel_sync"
+static void timer_slow(void *arg) {
+    (void)arg;
+    cc_atomic_fetch_add_u32(&g_test_timer_fired, 1, CC_MO_RELEASE);
+    nanosleep((const struct timespec[]){{0, 20000000L}}, NULL);
+    cc_atomic_fetch_add_u32(&g_test_timer_early, 1, CC_MO_RELEASE);
+}
+
+// Polls until "count" timers fired, up to 2 seconds
+static int wait_timers_fired(uint32_t count) {
+    for (int i = 0; i < 2000 && cc_atomic_load_u32(&g_test_timer_fired, CC_MO_ACQUIRE) < count; i++)
+        nanosleep((const struct timespec[]){{0, 1000000L}}, NULL);
+    return cc_atomic_load_u32(&g_test_timer_fired, CC_MO_ACQUIRE) == count;
+}
+
+// Test many one shot timers fire once and never early, and that canceled or moved timers behave
+void test_cc_timer_oneshot(void) {
+    uint32_t canceled = 0;
+    uint64_t now;
+
+    g_test_timer_fired = 0;
+    g_test_timer_early = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_wheel_init(&g_test_wheel, 1));
+    now = cc__time_now_ns();
+    for (size_t i = 0; i < TEST_TIMER_COUNT; i++) {
+        uint32_t delay = (uint32_t)(i * 7919 % 150);
+        cc_timer_init(&g_test_timers[i]);
+        g_test_timer_due_ns[i] = now + (uint64_t)delay * 1000000U;
+        TEST_ASSERT_EQUAL_INT(0, cc_timer_schedule(&g_test_wheel, &g_test_timers[i], delay, 0, timer_count, (void *)(uintptr_t)i));
+    }
+    // every tenth is canceled, unless it already fired
+    for (size_t i = 0; i < TEST_TIMER_COUNT; i += 10) {
+        int ret = cc_timer_cancel(&g_test_timers[i]);
+        TEST_ASSERT_TRUE(0 == ret || ENOENT == ret || EBUSY == ret);
+        if (0 == ret) canceled++;
+    }
+    TEST_ASSERT_TRUE(canceled > 0);
+    TEST_ASSERT_TRUE(wait_timers_fired(TEST_TIMER_COUNT - canceled));
+    TEST_ASSERT_EQUAL_UINT32(0, g_test_timer_early);
+    TEST_ASSERT_EQUAL_INT(ENOENT, cc_timer_cancel(&g_test_timers[1]));
+
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_schedule(&g_test_wheel, &g_test_timers[0], 3600000, 0, timer_count, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_cancel(&g_test_timers[0]));
+
+    // moving a pending timer from an hour to 5 ms
+    g_test_timer_fired = 0;
+    g_test_timer_due_ns[0] = cc__time_now_ns() + 5000000U;
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_schedule(&g_test_wheel, &g_test_timers[0], 3600000, 0, timer_count, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_schedule(&g_test_wheel, &g_test_timers[0], 5, 0, timer_count, NULL));
+    TEST_ASSERT_TRUE(wait_timers_fired(1));
+    TEST_ASSERT_EQUAL_UINT32(0, g_test_timer_early);
+    TEST_ASSERT_EQUAL_INT(-1, cc_timer_schedule(&g_test_wheel, &g_test_timers[0], 5, 0, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_wheel_destroy(&g_test_wheel));
+}
+
+// Test a periodic timer rearms itself until its callback cancels it
+void test_cc_timer_periodic(void) {
+    g_test_timer_fired = 0;
+    g_test_timer_early = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_wheel_init(&g_test_wheel, 0));
+    cc_timer_init(&g_test_timers[0]);
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_schedule(&g_test_wheel, &g_test_timers[0], 1, 2, timer_periodic, &g_test_timers[0]));
+    TEST_ASSERT_TRUE(wait_timers_fired(5));
+    nanosleep((const struct timespec[]){{0, 20000000L}}, NULL);
+    TEST_ASSERT_EQUAL_UINT32(5, cc_atomic_load_u32(&g_test_timer_fired, CC_MO_ACQUIRE));
+    TEST_ASSERT_EQUAL_UINT32(EBUSY, cc_atomic_load_u32(&g_test_timer_early, CC_MO_RELAXED));
+    TEST_ASSERT_EQUAL_INT(ENOENT, cc_timer_cancel(&g_test_timers[0]));
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_wheel_destroy(&g_test_wheel));
+}
+
+// Test a callback may free its own timer, and "cc_timer_cancel_sync" returns only once a callback is done
+void test_cc_timer_free(void) {
+    cc_timer *p_timer;
+    uint32_t fired;
+
+    g_test_timer_fired = 0;
+    g_test_timer_early = 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_wheel_init(&g_test_wheel, 1));
+    for (int i = 0; i < 100; i++) {
+        p_timer = (cc_timer *)malloc(sizeof(cc_timer));
+        TEST_ASSERT_NOT_NULL(p_timer);
+        cc_timer_init(p_timer);
+        TEST_ASSERT_EQUAL_INT(0, cc_timer_schedule(&g_test_wheel, p_timer, (uint32_t)(i % 10), 0, timer_free_self, p_timer));
+    }
+    TEST_ASSERT_TRUE(wait_timers_fired(100));
+
+    g_test_timer_fired = 0;
+    cc_timer_init(&g_test_timers[0]);
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_schedule(&g_test_wheel, &g_test_timers[0], 1, 1, timer_slow, NULL));
+    TEST_ASSERT_TRUE(wait_timers_fired(1));
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_cancel_sync(&g_test_timers[0]));
+    // every callback that started has returned, and none starts anymore
+    fired = cc_atomic_load_u32(&g_test_timer_fired, CC_MO_ACQUIRE);
+    TEST_ASSERT_EQUAL_UINT32(fired, cc_atomic_load_u32(&g_test_timer_early, CC_MO_ACQUIRE));
+    TEST_ASSERT_EQUAL_INT(ENOENT, cc_timer_cancel_sync(&g_test_timers[0]));
+    nanosleep((const struct timespec[]){{0, 10000000L}}, NULL);
+    TEST_ASSERT_EQUAL_INT(0, cc_timer_wheel_destroy(&g_test_wheel));
+    TEST_ASSERT_EQUAL_UINT32(fired, g_test_timer_fired);
+}
+
+// Shared state for the pipeline tests: items live in per token slots, the last stage checks the order
+#define TEST_PIPE_ITEMS 20000
+#define TEST_PIPE_TOKENS 8
+static uint64_t g_test_pipe_slots[TEST_PIPE_TOKENS];
+static uint64_t g_test_pipe_read = 0;
+static uint64_t g_test_pipe_sum = 0;
+static uint32_t g_test_pipe_in_flight = 0;
+static uint32_t g_test_pipe_max_in_flight = 0;
+static int64_t g_test_pipe_last = -1;
+static int g_test_pipe_ordered = 1;
+
+static void *pipe_read(void *p_item, uint32_t token, void *arg) {
+    uint32_t in_flight = cc_atomic_fetch_add_u32(&g_test_pipe_in_flight, 1, CC_MO_RELAXED) + 1;
+    (void)p_item;
+    (void)arg;
+    if (in_flight > g_test_pipe_max_in_flight) g_test_pipe_max_in_flight = in_flight;
+    if (g_test_pipe_read == TEST_PIPE_ITEMS) {
+        cc_atomic_fetch_sub_u32(&g_test_pipe_in_flight, 1, CC_MO_RELAXED);
+        return NULL;
+    }
+    g_test_pipe_slots[token] = g_test_pipe_read++;
+    return &g_test_pipe_slots[token];
+}
+
+// Parallel stage dropping multiples of 3 and tagging the rest
+static void *pipe_transform(void *p_item, uint32_t token, void *arg) {
+    uint64_t *p_value = (uint64_t *)p_item;
+    (void)arg;
+    if (p_value != &g_test_pipe_slots[token]) g_test_pipe_ordered = 0;
+    if (0 == *p_value % 3) {
+        cc_atomic_fetch_sub_u32(&g_test_pipe_in_flight, 1, CC_MO_RELAXED);
+        return NULL;
+    }
+    *p_value = (*p_value << 1) | 1;
+    return p_item;
+}
+
+static void *pipe_sum(void *p_item, uint32_t token, void *arg) {
+    (void)token;
+    (void)arg;
+    g_test_pipe_sum += *(uint64_t *)p_item >> 1;
+    return p_item;
+}
+
+static void *pipe_write(void *p_item, uint32_t token, void *arg) {
+    int64_t value = (int64_t)(*(uint64_t *)p_item >> 1);
+    (void)token;
+    (void)arg;
+    if (value <= g_test_pipe_last) g_test_pipe_ordered = 0;
+    g_test_pipe_last = value;
+    cc_atomic_fetch_sub_u32(&g_test_pipe_in_flight, 1, CC_MO_RELAXED);
+    return p_item;
+}
+
+// Test a read -> transform -> sum -> write pipeline keeps input order, drops items and bounds the tokens
+void test_cc_pipeline(void) {
+    cc_pipeline_stage stages[4] = {
+        { pipe_read, NULL, CC_PIPELINE_SERIAL_IN_ORDER },
+        { pipe_transform, NULL, CC_PIPELINE_PARALLEL },
+        { pipe_sum, NULL, CC_PIPELINE_SERIAL_OUT_OF_ORDER },
+        { pipe_write, NULL, CC_PIPELINE_SERIAL_IN_ORDER },
+    };
+    uint64_t expected = 0;
+
+    for (uint64_t i = 0; i < TEST_PIPE_ITEMS; i++) expected += (i % 3) ? i : 0;
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 3));
+    for (uint32_t tokens = 1; tokens <= TEST_PIPE_TOKENS; tokens += TEST_PIPE_TOKENS - 1) {
+        g_test_pipe_read = 0;
+        g_test_pipe_sum = 0;
+        g_test_pipe_max_in_flight = 0;
+        g_test_pipe_last = -1;
+        TEST_ASSERT_EQUAL_INT(0, cc_pipeline_run(&g_test_pool, stages, 4, tokens));
+        TEST_ASSERT_EQUAL_UINT64(expected, g_test_pipe_sum);
+        TEST_ASSERT_TRUE(g_test_pipe_ordered);
+        TEST_ASSERT_EQUAL_INT64(TEST_PIPE_ITEMS - 1, g_test_pipe_last);
+        TEST_ASSERT_EQUAL_UINT32(0, g_test_pipe_in_flight);
+        TEST_ASSERT_TRUE(g_test_pipe_max_in_flight <= tokens);
+    }
+
+    stages[0].mode = CC_PIPELINE_PARALLEL;
+    TEST_ASSERT_EQUAL_INT(-1, cc_pipeline_run(&g_test_pool, stages, 4, 4));
+    TEST_ASSERT_EQUAL_INT(-1, cc_pipeline_run(&g_test_pool, stages, 4, 0));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Shared state for the graph tests: nodes stamp the order they ran in
+#define TEST_GRAPH_LAYERS 10
+#define TEST_GRAPH_WIDTH 20
+static uint32_t g_test_graph_clock = 0;
+static uint32_t g_test_graph_stamp[TEST_GRAPH_LAYERS * TEST_GRAPH_WIDTH];
+static uint32_t g_test_graph_runs[TEST_GRAPH_LAYERS * TEST_GRAPH_WIDTH];
+
+static void node_graph_stamp(void *arg) {
+    size_t i = (size_t)(uintptr_t)arg;
+    g_test_graph_stamp[i] = cc_atomic_fetch_add_u32(&g_test_graph_clock, 1, CC_MO_ACQ_REL);
+    g_test_graph_runs[i]++;
+}
+
+// Test a layered DAG runs every node once per run after its predecessors, over several runs
+void test_cc_graph_run(void) {
+    cc_graph graph;
+    cc_graph_node *p_nodes[TEST_GRAPH_LAYERS * TEST_GRAPH_WIDTH];
+    int ok = 1;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 3));
+    TEST_ASSERT_EQUAL_INT(0, cc_graph_init(&graph));
+    memset(g_test_graph_runs, 0, sizeof(g_test_graph_runs));
+    for (size_t i = 0; i < TEST_GRAPH_LAYERS * TEST_GRAPH_WIDTH; i++)
+        TEST_ASSERT_NOT_NULL(p_nodes[i] = cc_graph_add_node(&graph, node_graph_stamp, (void *)(uintptr_t)i));
+    // every node waits for three nodes of the layer above
+    for (size_t layer = 1; layer < TEST_GRAPH_LAYERS; layer++) {
+        for (size_t j = 0; j < TEST_GRAPH_WIDTH; j++) {
+            for (size_t k = 0; k < 3; k++) {
+                size_t from = (layer - 1) * TEST_GRAPH_WIDTH + (j * 7 + k * 5) % TEST_GRAPH_WIDTH;
+                TEST_ASSERT_EQUAL_INT(0, cc_graph_add_edge(p_nodes[from], p_nodes[layer * TEST_GRAPH_WIDTH + j]));
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(-1, cc_graph_add_edge(p_nodes[0], p_nodes[0]));
+
+    for (uint32_t run = 1; run <= 3; run++) {
+        TEST_ASSERT_EQUAL_INT(0, cc_graph_run(&graph, &g_test_pool));
+        for (size_t i = 0; i < TEST_GRAPH_LAYERS * TEST_GRAPH_WIDTH; i++) {
+            if (g_test_graph_runs[i] != run) ok = 0;
+            for (uint32_t e = 0; e < p_nodes[i]->n_succ; e++) {
+                size_t to = (size_t)(uintptr_t)p_nodes[i]->pp_succ[e]->arg;
+                if (g_test_graph_stamp[i] >= g_test_graph_stamp[to]) ok = 0;
+            }
+        }
+        TEST_ASSERT_TRUE(ok);
+    }
+    TEST_ASSERT_EQUAL_INT(0, cc_graph_destroy(&graph));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+// Test a cycle is reported and leaves the graph reusable
+void test_cc_graph_cycle(void) {
+    cc_graph graph;
+    cc_graph_node *p_root, *p_a, *p_b;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 2));
+    TEST_ASSERT_EQUAL_INT(0, cc_graph_init(&graph));
+    memset(g_test_graph_runs, 0, sizeof(g_test_graph_runs));
+    TEST_ASSERT_EQUAL_INT(0, cc_graph_run(&graph, &g_test_pool));
+    p_root = cc_graph_add_node(&graph, node_graph_stamp, (void *)(uintptr_t)0);
+    p_a = cc_graph_add_node(&graph, node_graph_stamp, (void *)(uintptr_t)1);
+    p_b = cc_graph_add_node(&graph, node_graph_stamp, (void *)(uintptr_t)2);
+    TEST_ASSERT_EQUAL_INT(0, cc_graph_add_edge(p_root, p_a));
+    TEST_ASSERT_EQUAL_INT(0, cc_graph_add_edge(p_a, p_b));
+    TEST_ASSERT_EQUAL_INT(0, cc_graph_add_edge(p_b, p_a));
+    for (int run = 0; run < 2; run++) TEST_ASSERT_EQUAL_INT(EDEADLK, cc_graph_run(&graph, &g_test_pool));
+    TEST_ASSERT_EQUAL_UINT32(2, g_test_graph_runs[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, g_test_graph_runs[1]);
+    TEST_ASSERT_EQUAL_INT(0, cc_graph_destroy(&graph));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+#define TEST_FIBERS         1000
+#define TEST_FIBER_YIELDS   10
+
+static cc_fiber g_test_fibers[TEST_FIBERS];
+static uint32_t g_test_fiber_steps = 0;
+static int g_test_fiber_results[4];
+
+static void fiber_yield_steps(void *arg) {
+    (void)arg;
+    for (int i = 0; i < TEST_FIBER_YIELDS; i++) {
+        cc_atomic_fetch_add_u32(&g_test_fiber_steps, 1, CC_MO_RELAXED);
+        if (0 != cc_fiber_yield()) return;
+    }
+    cc_atomic_fetch_add_u32(&g_test_fiber_steps, 1, CC_MO_RELAXED);
+}
+
+static void fiber_join_child(void *arg) {
+    cc_fiber *p_child = (cc_fiber *)arg;
+
+    g_test_fiber_results[0] = cc_fiber_self() == &g_test_fibers[0];
+    g_test_fiber_results[1] = cc_fiber_create(p_child, &g_test_pool, fiber_yield_steps, NULL);
+    g_test_fiber_results[2] = cc_fiber_join(p_child);
+    g_test_fiber_results[3] = cc_fiber_join(cc_fiber_self());
+}
+
+void test_cc_fiber_yield_join(void) {
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 3));
+    for (int run = 0; run < 2; run++) {  /* the second run reuses the cached stacks */
+        cc_atomic_store_u32(&g_test_fiber_steps, 0, CC_MO_RELAXED);
+        for (int i = 0; i < TEST_FIBERS; i++) {
+            TEST_ASSERT_EQUAL_INT(0, cc_fiber_create(&g_test_fibers[i], &g_test_pool, fiber_yield_steps, NULL));
+        }
+        for (int i = 0; i < TEST_FIBERS; i++) TEST_ASSERT_EQUAL_INT(0, cc_fiber_join(&g_test_fibers[i]));
+        TEST_ASSERT_EQUAL_UINT32(TEST_FIBERS * (TEST_FIBER_YIELDS + 1), cc_atomic_load_u32(&g_test_fiber_steps, CC_MO_RELAXED));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, cc_fiber_yield());
+    TEST_ASSERT_NULL(cc_fiber_self());
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+void test_cc_fiber_nested_join(void) {
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 1));
+    cc_atomic_store_u32(&g_test_fiber_steps, 0, CC_MO_RELAXED);
+    memset(g_test_fiber_results, -1, sizeof(g_test_fiber_results));
+    TEST_ASSERT_EQUAL_INT(0, cc_fiber_create(&g_test_fibers[0], &g_test_pool, fiber_join_child, &g_test_fibers[1]));
+    TEST_ASSERT_EQUAL_INT(0, cc_fiber_join(&g_test_fibers[0]));
+    TEST_ASSERT_EQUAL_INT(0, cc_fiber_join(&g_test_fibers[0]));
+    TEST_ASSERT_EQUAL_INT(1, g_test_fiber_results[0]);
+    TEST_ASSERT_EQUAL_INT(0, g_test_fiber_results[1]);
+    TEST_ASSERT_EQUAL_INT(0, g_test_fiber_results[2]);
+    TEST_ASSERT_EQUAL_INT(EDEADLK, g_test_fiber_results[3]);
+    TEST_ASSERT_EQUAL_UINT32(TEST_FIBER_YIELDS + 1, cc_atomic_load_u32(&g_test_fiber_steps, CC_MO_RELAXED));
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
+#define TEST_COROUTINES     1000
+
+typedef struct {
+    cc_co co;
+    uint64_t a, b;
+    int i;
+    uint64_t value;
+} test_fib_co;
+
+typedef struct {
+    cc_co co;
+    uint32_t ready;
+    int steps;
+} test_wait_co;
+
+static test_wait_co g_test_wait_cos[TEST_COROUTINES];
+
+static int co_fib(test_fib_co *p_fib, int count) {
+    CC_CO_BEGIN(&p_fib->co);
+    p_fib->a = 0;
+    p_fib->b = 1;
+    for (p_fib->i = 0; p_fib->i < count; p_fib->i++) {
+        p_fib->value = p_fib->a;
+        p_fib->b += p_fib->a;
+        p_fib->a = p_fib->b - p_fib->a;
+        CC_CO_YIELD(&p_fib->co);
+    }
+    CC_CO_END(&p_fib->co);
+}
+
+static int co_wait_ready(test_wait_co *p_wait) {
+    CC_CO_BEGIN(&p_wait->co);
+    CC_CO_AWAIT(&p_wait->co, cc_atomic_load_u32(&p_wait->ready, CC_MO_ACQUIRE));
+    p_wait->steps++;
+    CC_CO_YIELD(&p_wait->co);
+    p_wait->steps++;
+    CC_CO_RETURN(&p_wait->co);
+    p_wait->steps++;  /* never reached */
+    CC_CO_END(&p_wait->co);
+}
+
+static void task_co_ready(void *arg) {
+    test_wait_co *p_wait = (test_wait_co *)arg;
+    cc_atomic_store_u32(&p_wait->ready, 1, CC_MO_RELEASE);
+}
+
+void test_cc_co_yield(void) {
+    test_fib_co fib = { CC_CO_INIT, 0, 0, 0, 0 };
+    uint64_t expected[] = { 0, 1, 1, 2, 3, 5, 8, 13, 21, 34 };
+
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT(CC_CO_PENDING, co_fib(&fib, 10));
+        TEST_ASSERT_EQUAL_UINT64(expected[i], fib.value);
+    }
+    TEST_ASSERT_FALSE(cc_co_done(&fib.co));
+    TEST_ASSERT_EQUAL_INT(CC_CO_DONE, co_fib(&fib, 10));
+    TEST_ASSERT_TRUE(cc_co_done(&fib.co));
+    TEST_ASSERT_EQUAL_INT(CC_CO_DONE, co_fib(&fib, 10));
+    cc_co_init(&fib.co);
+    TEST_ASSERT_EQUAL_INT(CC_CO_PENDING, co_fib(&fib, 10));
+    TEST_ASSERT_EQUAL_UINT64(0, fib.value);
+}
+
+void test_cc_co_await(void) {
+    int pending = TEST_COROUTINES;
+
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_init(&g_test_pool, 2));
+    for (int i = 0; i < TEST_COROUTINES; i++) {
+        cc_co_init(&g_test_wait_cos[i].co);
+        g_test_wait_cos[i].ready = 0;
+        g_test_wait_cos[i].steps = 0;
+        TEST_ASSERT_EQUAL_INT(CC_CO_PENDING, co_wait_ready(&g_test_wait_cos[i]));
+    }
+    for (int i = 0; i < TEST_COROUTINES; i++) {
+        TEST_ASSERT_EQUAL_INT(0, cc_pool_submit(&g_test_pool, task_co_ready, &g_test_wait_cos[i]));
+    }
+    while (pending) {
+        pending = 0;
+        for (int i = 0; i < TEST_COROUTINES; i++) {
+            if (CC_CO_PENDING == co_wait_ready(&g_test_wait_cos[i])) pending++;
+        }
+    }
+    for (int i = 0; i < TEST_COROUTINES; i++) TEST_ASSERT_EQUAL_INT(2, g_test_wait_cos[i].steps);
+    TEST_ASSERT_EQUAL_INT(0, cc_pool_destroy(&g_test_pool));
+}
+
 // --- Main Test Runner ---
 int main(void) {
     UNITY_BEGIN();
@@ -367,6 +2204,98 @@ int main(void) {
     RUN_TEST(test_cc_tls_set_and_get_same_thread);
     RUN_TEST(test_cc_tls_set_and_get_multiple_threads);
     RUN_TEST(test_cc_tls_cleanup);
+    RUN_TEST(test_cc_call_once);
+
+    // Wait-on-address tests
+    RUN_TEST(test_cc_wait_timeout);
+    RUN_TEST(test_cc_wait_and_wake);
+
+    // Mutex tests
+    RUN_TEST(test_cc_mtx_lock_and_trylock);
+    RUN_TEST(test_cc_mtx_timedlock);
+    RUN_TEST(test_cc_mtx_contention);
+
+    // Rwlock tests
+    RUN_TEST(test_cc_rwlock_try);
+    RUN_TEST(test_cc_rwlock_exclusion);
+
+    // Condition variable tests
+    RUN_TEST(test_cc_cond_signal);
+    RUN_TEST(test_cc_cond_broadcast);
+    RUN_TEST(test_cc_cond_timedwait);
+
+    // Semaphore tests
+    RUN_TEST(test_cc_sem_counts);
+    RUN_TEST(test_cc_sem_batch);
+    RUN_TEST(test_cc_sem_timedwait);
+
+    // Barrier tests
+    RUN_TEST(test_cc_barrier_central);
+    RUN_TEST(test_cc_barrier_dissemination);
+
+    // Parking lot tests
+    RUN_TEST(test_cc_park);
+    RUN_TEST(test_cc_lock);
+    RUN_TEST(test_cc_event);
+
+    // Queue lock tests
+    RUN_TEST(test_cc_mcs_lock);
+    RUN_TEST(test_cc_clh_lock);
+    RUN_TEST(test_cc_cohort_lock);
+
+    // Seqlock tests
+    RUN_TEST(test_cc_seqlock_retry);
+    RUN_TEST(test_cc_seqlock_snapshot);
+    RUN_TEST(test_cc_seqlock_wait);
+
+    // Atomics tests
+    RUN_TEST(test_cc_atomic_ops);
+    RUN_TEST(test_cc_atomic_counter);
+
+    // Pool tests
+    RUN_TEST(test_cc_pool_submit_wait);
+    RUN_TEST(test_cc_pool_recursive);
+    RUN_TEST(test_cc_pool_elastic);
+    RUN_TEST(test_cc_pool_elastic_retire_race);
+
+    // Task group tests
+    RUN_TEST(test_cc_task_group_fork_join);
+    RUN_TEST(test_cc_task_group_scope);
+
+    // Future tests
+    RUN_TEST(test_cc_future_promise);
+    RUN_TEST(test_cc_future_compose);
+
+    // Parallel algorithm tests
+    RUN_TEST(test_cc_parallel_for_schedules);
+    RUN_TEST(test_cc_parallel_reduce);
+    RUN_TEST(test_cc_parallel_scan);
+    RUN_TEST(test_cc_parallel_sort);
+    RUN_TEST(test_cc_parallel_radix_sort);
+
+    // Priority pool tests
+    RUN_TEST(test_cc_prio_pool_bands);
+    RUN_TEST(test_cc_prio_pool_aging);
+
+    // Timer tests
+    RUN_TEST(test_cc_timer_oneshot);
+    RUN_TEST(test_cc_timer_periodic);
+    RUN_TEST(test_cc_timer_free);
+
+    // Pipeline tests
+    RUN_TEST(test_cc_pipeline);
+
+    // Graph tests
+    RUN_TEST(test_cc_graph_run);
+    RUN_TEST(test_cc_graph_cycle);
+
+    // Fiber tests
+    RUN_TEST(test_cc_fiber_yield_join);
+    RUN_TEST(test_cc_fiber_nested_join);
+
+    // Coroutine tests
+    RUN_TEST(test_cc_co_yield);
+    RUN_TEST(test_cc_co_await);
 
     return UNITY_END();
 }
\ No newline at end of file